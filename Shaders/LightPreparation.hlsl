@@ -118,10 +118,10 @@ void main(uint dispatchThreadID : SV_DispatchThreadID)
 			longEdges[1] = edges[1];
 		}
 
-		const Texture2D<float3> texture = ResourceDescriptorHeap[textureMapInfo.Descriptor];
+		const Texture2DArray<float3> texture = ResourceDescriptorHeap[textureMapInfo.Descriptor];
 		emission *= texture.SampleGrad(
 			g_anisotropicSampler,
-			(textureCoordinates[0] + textureCoordinates[1] + textureCoordinates[2]) / 3,
+			float3((textureCoordinates[0] + textureCoordinates[1] + textureCoordinates[2]) / 3, textureMapInfo.ArraySlice),
 			shortEdge * (2.0f / 3),
 			(longEdges[0] + longEdges[1]) / 3
 		);
@@ -38,6 +38,6 @@ struct TextureMapType
 
 struct TextureMapInfo
 {
-	uint Descriptor, TextureCoordinateIndex;
-	uint2 _;
+	uint Descriptor, TextureCoordinateIndex, ArraySlice;
+	uint _;
 };
@@ -53,9 +53,9 @@ void GetTextureCoordinates(
 template <typename T>
 T Sample(TextureMapInfo info, float2 textureCoordinates[2])
 {
-	const Texture2D<T> texture = ResourceDescriptorHeap[info.Descriptor];
+	const Texture2DArray<T> texture = ResourceDescriptorHeap[info.Descriptor];
 	const float2 textureCoordinate = textureCoordinates[info.TextureCoordinateIndex];
-	return texture.SampleLevel(g_anisotropicSampler, textureCoordinate, 0);
+	return texture.SampleLevel(g_anisotropicSampler, float3(textureCoordinate, info.ArraySlice), 0);
 }
 
 void EvaluateBaseColor(
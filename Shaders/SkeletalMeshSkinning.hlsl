@@ -4,10 +4,11 @@
 
 cbuffer _ : register(b0)
 {
+	SkinDesc g_skinDesc;
 	uint g_vertexCount;
 }
 
-StructuredBuffer<VertexPositionNormalTangentSkin> g_skeletalVertices : register(t0);
+ByteAddressBuffer g_skeletalVertices : register(t0);
 
 struct row_major_float3x4
 {
@@ -19,7 +20,7 @@ RWStructuredBuffer<VertexPositionNormalTangentTexture> g_vertices : register(u0)
 RWStructuredBuffer<float16_t4> g_motionVectors : register(u1);
 
 [RootSignature(
-	"RootConstants(num32BitConstants=1, b0),"
+	"RootConstants(num32BitConstants=5, b0),"
 	"SRV(t0),"
 	"SRV(t1),"
 	"UAV(u0),"
@@ -34,19 +35,15 @@ void main(uint vertexIndex : SV_DispatchThreadID)
 	}
 
 	float3x4 transform = 0;
-	const VertexPositionNormalTangentSkin skeletalVertex = g_skeletalVertices[vertexIndex];
-	const float weights[] =
-	{
-		skeletalVertex.Weights[0],
-		skeletalVertex.Weights[1],
-		skeletalVertex.Weights[2],
-		1 - skeletalVertex.Weights[0] - skeletalVertex.Weights[1] - skeletalVertex.Weights[2]
-	};
+	const VertexPositionNormalTangentSkin skeletalVertex = g_skinDesc.Load(g_skeletalVertices, vertexIndex);
 	[unroll]
 	for (uint i = 0; i < 4; i++)
 	{
-		const uint joint = skeletalVertex.Joints[i];
-		transform += weights[i] * g_skeletalTransforms[joint].Value;
+		// Influences dropped at import have no weight, so their transforms are not fetched
+		if (skeletalVertex.Weights[i] > 0)
+		{
+			transform += skeletalVertex.Weights[i] * g_skeletalTransforms[skeletalVertex.Joints[i]].Value;
+		}
 	}
 
 	const float3
@@ -2,17 +2,50 @@
 
 #include "Packing.hlsli"
 
+// Same as GetOrthonormalBasis in Vertex.ixx
+void GetOrthonormalBasis(float3 normal, out float3 tangent, out float3 bitangent)
+{
+	const float sign = normal.z >= 0 ? 1 : -1, a = -1 / (sign + normal.z), b = normal.x * normal.y * a;
+	tangent = float3(1 + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+	bitangent = float3(b, sign + normal.y * normal.y * a, -normal.y);
+}
+
+float3 DecodeTangentFrameNormal(uint value)
+{
+	float3 normal;
+	normal.xy = float2(value & 0xfff, (value >> 12) & 0xfff) / 0xfff * 2 - 1;
+	normal.z = 1 - abs(normal.x) - abs(normal.y);
+	const float t = saturate(-normal.z);
+	normal.xy += select(normal.xy >= 0, -t, t);
+	return normalize(normal);
+}
+
+float3 DecodeTangentFrameTangent(uint value)
+{
+	float3 tangent, bitangent;
+	GetOrthonormalBasis(DecodeTangentFrameNormal(value), tangent, bitangent);
+	float sine, cosine;
+	sincos((value >> 24) * (2 * 3.14159265f / 256), sine, cosine);
+	return cosine * tangent + sine * bitangent;
+}
+
 struct VertexDesc
 {
 	uint Stride;
-	uint3 _;
+	float3 PositionScale;
 	struct
 	{
 		uint Normal, Tangent, TextureCoordinates[2];
 	} AttributeOffsets;
+	float3 PositionOffset;
+	uint IsCompact;
 
 	float3 LoadPosition(ByteAddressBuffer buffer, uint index)
 	{
+		if (IsCompact)
+		{
+			return PositionOffset + PositionScale * Unpack_R16G16B16_SNORM(buffer.Load<int16_t3>(Stride * index));
+		}
 		return buffer.Load<float3>(Stride * index);
 	}
 
@@ -25,6 +58,10 @@ struct VertexDesc
 
 	float3 LoadNormal(ByteAddressBuffer buffer, uint index)
 	{
+		if (IsCompact)
+		{
+			return DecodeTangentFrameNormal(buffer.Load(Stride * index + AttributeOffsets.Normal));
+		}
 		return Unpack_R16G16B16_SNORM(buffer.Load<int16_t3>(Stride * index + AttributeOffsets.Normal));
 	}
 
@@ -37,6 +74,10 @@ struct VertexDesc
 
 	float3 LoadTangent(ByteAddressBuffer buffer, uint index)
 	{
+		if (IsCompact)
+		{
+			return DecodeTangentFrameTangent(buffer.Load(Stride * index + AttributeOffsets.Tangent));
+		}
 		return Unpack_R16G16B16_SNORM(buffer.Load<int16_t3>(Stride * index + AttributeOffsets.Tangent));
 	}
 
@@ -85,3 +126,37 @@ struct VertexPositionNormalTangentSkin
 	uint16_t4 Joints;
 	float4 Weights;
 };
+
+// Same as SkinDesc in Vertex.ixx
+struct SkinDesc
+{
+	uint Stride, WeightsOffset, Has8BitJoints, Has8BitWeights;
+
+	VertexPositionNormalTangentSkin Load(ByteAddressBuffer buffer, uint index)
+	{
+		const uint address = Stride * index;
+		VertexPositionNormalTangentSkin vertex;
+		vertex.Position = buffer.Load<float3>(address);
+		vertex.Normal = buffer.Load<int16_t3>(address + 12);
+		vertex.Tangent = buffer.Load<int16_t3>(address + 18);
+		if (Has8BitJoints)
+		{
+			const uint joints = buffer.Load(address + 24);
+			vertex.Joints = uint16_t4(joints & 0xff, (joints >> 8) & 0xff, (joints >> 16) & 0xff, joints >> 24);
+		}
+		else
+		{
+			vertex.Joints = buffer.Load<uint16_t4>(address + 24);
+		}
+		if (Has8BitWeights)
+		{
+			const uint weights = buffer.Load(address + WeightsOffset);
+			vertex.Weights = float4(weights & 0xff, (weights >> 8) & 0xff, (weights >> 16) & 0xff, weights >> 24) / 0xff;
+		}
+		else
+		{
+			vertex.Weights = buffer.Load<uint16_t4>(address + WeightsOffset) / (float)0xffff;
+		}
+		return vertex;
+	}
+};
@@ -103,6 +103,10 @@ export {
 
 		auto GetDuration() const { return m_duration; }
 
+		const auto& GetKeyframeCollections() const { return m_keyframeCollections; }
+
+		const auto& GetTargetNodes() const { return m_targetNodes; }
+
 		auto GetTime() const { return m_time; }
 		void SetTime(double seconds = 0) { m_time = clamp(seconds, 0.0, m_duration); }
 
@@ -54,6 +54,7 @@ import PostProcessing.Bloom;
 import PostProcessing.MipmapGeneration;
 import PostProcessing.NRDComposition;
 import Raytracing;
+import ResidentAssetCache;
 import ResourceHelpers;
 import RTXDI;
 import RTXDIResources;
@@ -62,6 +63,7 @@ import SharedData;
 import StepTimer;
 import StringConverters;
 import Texture;
+import TextureStreaming;
 import ThreadHelpers;
 
 using namespace DirectX;
@@ -160,6 +162,13 @@ struct App::Impl : IDeviceNotify {
 		{
 			m_deviceResources->Prepare();
 
+			UpdateSceneStreaming();
+
+			UpdateSceneHotReload();
+
+			// Ahead of Update, so that object data picks up the descriptors of the mips streamed in
+			m_textureStreamer.Update(m_deviceResources->GetCommandList());
+
 			m_stepTimer.Tick([&] { Update(); });
 
 			Render();
@@ -222,6 +231,8 @@ struct App::Impl : IDeviceNotify {
 
 		m_scene.reset();
 
+		m_residentAssetCache.Clear();
+
 		m_GPUBuffers = {};
 
 		m_textures = {};
@@ -303,6 +314,7 @@ private:
 
 	struct FutureNames {
 		MAKE_NAME(Scene);
+		MAKE_NAME(SceneReload);
 	};
 	unordered_map<string, future<void>> m_futures;
 
@@ -378,7 +390,14 @@ private:
 
 	path m_sceneFilePath;
 	string m_sceneErrorMessage;
+	// Declared before the scene and the resident asset cache, as it streams the textures they hold
+	TextureStreamer m_textureStreamer{ { .Budget = GetTextureStreamingBudget() } };
+	// Declared before the scene so that it outlives the assets the scene takes from it
+	ResidentAssetCache m_residentAssetCache{ GetResidentAssetCacheBudget() };
 	unique_ptr<Scene> m_scene;
+	bool m_isSceneStreaming{}, m_isSceneStarted{};
+	file_time_type m_sceneFileWriteTime;
+	chrono::steady_clock::time_point m_sceneHotReloadCheckTime;
 
 	struct { bool IsVisible, HasFocus = true, IsFileDialogOpen, IsSettingsWindowOpen; } m_UIStates{};
 	vector<unique_ptr<Descriptor>> m_ImGUIDescriptors;
@@ -612,11 +631,22 @@ private:
 
 				if (!m_scene->IsStatic()) {
 					m_scene->SkinSkeletalMeshes(commandList);
+				}
 
+				// LODs follow the camera, so static scenes may switch BLASes as well
+				auto& LODSelection = m_scene->LODSelection;
+				LODSelection.ViewPosition = m_camera.Position;
+				LODSelection.PixelsPerUnit = static_cast<float>(m_renderSize.x) / (2 * tan(m_cameraController.GetHorizontalFieldOfView() / 2));
+				if (!m_scene->IsStatic() || m_scene->MeshOptimization.LOD.IsEnabled) {
 					m_scene->CreateAccelerationStructures(commandList);
-					commandList.CompactAccelerationStructures();
 				}
 
+				// Streamed in from the next frame on
+				m_scene->RequestTextureMips();
+
+				// BLASes built while a progressive load commits render objects are compacted here as well
+				commandList.CompactAccelerationStructures();
+
 				m_scene->CollectGarbage();
 
 				RenderScene();
@@ -689,7 +719,7 @@ private:
 	}
 
 	bool IsSceneLoading() const { return m_futures.contains(FutureNames::Scene); }
-	bool IsSceneReady() const { return !IsSceneLoading() && m_scene; }
+	bool IsSceneReady() const { return m_scene && (!IsSceneLoading() || m_isSceneStarted); }
 
 	void LoadScene(const path& filePath) {
 		shared_ptr<MySceneDesc> sceneDesc;
@@ -705,25 +735,37 @@ private:
 		}
 
 		m_sceneFilePath = filePath;
+		m_sceneFileWriteTime = GetLastWriteTime(filePath);
 
-		{
-			m_scene.reset();
+		ResetScene();
 
-			m_GPUBuffers.InstanceData.reset();
-			m_GPUBuffers.ObjectData.reset();
+		const auto isProgressive = g_graphicsSettings.IsProgressiveSceneLoadingEnabled;
 
-			m_RTXDIResources.ResetLightResources();
-		}
+		m_scene = make_unique<MyScene>(m_deviceResources->GetDeviceContext());
+		m_scene->TextureCompression = {
+			.IsEnabled = g_graphicsSettings.IsTextureCompressionEnabled,
+			.CacheDirectoryPath = ResolveResourcePath(L"Cache/Textures")
+		};
+		m_scene->TexturePacking.IsEnabled = g_graphicsSettings.IsTexturePackingEnabled;
+		m_scene->IsVertexCompressionEnabled = g_graphicsSettings.IsVertexCompressionEnabled;
+		m_scene->MeshOptimization.LOD.IsEnabled = g_graphicsSettings.IsMeshLODEnabled;
+		m_isSceneStreaming = isProgressive;
 
-		m_futures[FutureNames::Scene] = StartDetachedFuture([&, sceneDesc] {
+		const auto isTextureStreamingEnabled = g_graphicsSettings.IsTextureStreamingEnabled;
+
+		m_futures[FutureNames::Scene] = StartDetachedFuture([&, sceneDesc, isProgressive, isTextureStreamingEnabled] {
 			try {
-			m_scene = make_unique<MyScene>(m_deviceResources->GetDeviceContext());
-			m_scene->Load(*sceneDesc);
+			m_scene->Load(*sceneDesc, isProgressive, &m_residentAssetCache, isTextureStreamingEnabled ? &m_textureStreamer : nullptr);
 
-			OnSceneLoaded();
+			if (!isProgressive) {
+				OnSceneLoaded();
+			}
 		}
 		catch (const exception& e) {
-			m_scene.reset();
+			// A progressively loaded scene is being rendered, so it is released by UpdateSceneStreaming instead
+			if (!isProgressive) {
+				m_scene.reset();
+			}
 
 			m_sceneErrorMessage = e.what();
 		}
@@ -737,12 +779,158 @@ private:
 			});
 	}
 
+	void ResetScene() {
+		if (const auto pFuture = m_futures.find(FutureNames::SceneReload); pFuture != cend(m_futures)) {
+			pFuture->second.wait();
+			m_futures.erase(pFuture);
+		}
+
+		m_scene.reset();
+
+		m_residentAssetCache.Trim();
+
+		m_isSceneStreaming = m_isSceneStarted = false;
+
+		m_GPUBuffers.InstanceData.reset();
+		m_GPUBuffers.ObjectData.reset();
+
+		m_RTXDIResources.ResetLightResources();
+	}
+
+	// Brings the render objects of a progressive load into the scene; runs on the render thread
+	void UpdateSceneStreaming() {
+		if (!m_isSceneStreaming) {
+			return;
+		}
+
+		const auto isLoading = IsSceneLoading();
+		if (!isLoading && !empty(m_sceneErrorMessage)) {
+			ResetScene();
+
+			return;
+		}
+
+		if (!m_scene->IsReady()) {
+			return;
+		}
+
+		if (!m_isSceneStarted) {
+			m_isSceneStarted = true;
+
+			ResetCamera();
+		}
+
+		if (m_scene->CommitLoadedRenderObjects(m_deviceResources->GetCommandList())) {
+			CreateStructuredBuffers();
+
+			PrepareLightResources();
+
+			m_resetHistory = true;
+		}
+
+		if (!isLoading) {
+			m_isSceneStreaming = false;
+
+			LogSceneLoadStatistics();
+		}
+	}
+
+	// Polls the scene file and the files it references while hot reload is enabled, and patches the scene when any has changed
+	void UpdateSceneHotReload() {
+		if (const auto pFuture = m_futures.find(FutureNames::SceneReload); pFuture != cend(m_futures)) {
+			if (pFuture->second.wait_for(0s) != future_status::ready) {
+				return;
+			}
+
+			m_futures.erase(pFuture);
+
+			if (m_scene->CommitReload(m_deviceResources->GetCommandList())) {
+				CreateStructuredBuffers();
+
+				PrepareLightResources();
+
+				m_resetHistory = true;
+			}
+
+			return;
+		}
+
+		if (!g_graphicsSettings.IsSceneHotReloadEnabled
+			|| !IsSceneReady() || IsSceneLoading()
+			|| !_wcsicmp(m_sceneFilePath.extension().c_str(), L".scenepack")) {
+			return;
+		}
+
+		const auto now = chrono::steady_clock::now();
+		if (now - m_sceneHotReloadCheckTime < 500ms) {
+			return;
+		}
+		m_sceneHotReloadCheckTime = now;
+
+		const auto sceneFileWriteTime = GetLastWriteTime(m_sceneFilePath);
+		if (sceneFileWriteTime == m_sceneFileWriteTime && !m_scene->HasModifiedFiles()) {
+			return;
+		}
+		m_sceneFileWriteTime = sceneFileWriteTime;
+
+		m_futures[FutureNames::SceneReload] = StartDetachedFuture([&] {
+			try {
+				const MySceneDesc sceneDesc(m_sceneFilePath);
+				m_scene->PrepareReload(sceneDesc, &m_residentAssetCache);
+
+				m_sceneErrorMessage.clear();
+			}
+			catch (const exception& e) {
+				// The scene stays as it was, and the next change of the files is tried again
+				m_sceneErrorMessage = e.what();
+			}
+			});
+	}
+
 	void OnSceneLoaded() {
 		CreateStructuredBuffers();
 
 		ResetCamera();
 
 		PrepareLightResources();
+
+		LogSceneLoadStatistics();
+	}
+
+	static ResidentAssetCache::Budget GetResidentAssetCacheBudget() {
+		const auto& settings = g_graphicsSettings.ResidentAssetCache;
+		return { .CPU = size_t{ settings.CPUBudget } << 20, .GPU = size_t{ settings.GPUBudget } << 20 };
+	}
+
+	static size_t GetTextureStreamingBudget() { return size_t{ g_graphicsSettings.TextureStreaming.Budget } << 20; }
+
+	void LogSceneLoadStatistics() const {
+		const auto ToMilliseconds = [](chrono::steady_clock::duration value) { return chrono::duration<double, milli>(value).count(); };
+
+		const auto& statistics = m_scene->GetLoadStatistics();
+
+		string log = format(
+			"Scene loaded in {:.1f} ms, first model ready after {:.1f} ms\n",
+			ToMilliseconds(statistics.TotalTime), ToMilliseconds(statistics.FirstModelTime)
+		);
+		const auto usage = m_residentAssetCache.GetUsage();
+		log += format(
+			"  Resident: {} items reused, {} cached using {:.1f} MB CPU and {:.1f} MB GPU\n",
+			statistics.ResidentItemCount, usage.EntryCount, usage.CPU / 1e6, usage.GPU / 1e6
+		);
+		for (const auto& [name, stage, workerCount] : initializer_list<tuple<string_view, const Scene::LoadStatistics::Stage&, size_t>>{
+			{ "Decode", statistics.Decode, statistics.DecodeWorkerCount },
+			{ "Upload and BLAS build", statistics.Upload, 1 },
+			{ "Animation", statistics.Animation, 1 }
+			}) {
+			const auto busyTime = ToMilliseconds(stage.BusyTime) / max<size_t>(workerCount, 1);
+			log += format(
+				"  {}: {} items, {:.1f} MB in {:.1f} ms ({:.1f} items/s, {:.1f} MB/s)\n",
+				name, stage.ItemCount, stage.ByteCount / 1e6, busyTime,
+				busyTime > 0 ? stage.ItemCount * 1e3 / busyTime : 0.0, busyTime > 0 ? stage.ByteCount / 1e3 / busyTime : 0.0
+			);
+		}
+		OutputDebugStringA(log.c_str());
 	}
 
 	void CreatePipelineStates() {
@@ -1036,6 +1224,7 @@ private:
 					.ObjectToWorld = _instanceData.ObjectToWorld
 				};
 
+				const auto geometryCount = static_cast<uint32_t>(size(meshNode->Meshes)), LODCount = m_scene->GetLODCount(*meshNode);
 				for (uint32_t geometryIndex = 0; const auto & mesh : meshNode->Meshes) {
 					auto& _objectData = objectData[_instanceData.FirstGeometryIndex + geometryIndex];
 
@@ -1051,17 +1240,25 @@ private:
 
 					if (mesh->TextureIndex != ~0u) {
 						for (uint32_t i = 0;
-							const auto & [Texture, TextureCoordinateIndex] : renderObject.Model.Textures[mesh->TextureIndex]) {
+							const auto & [Texture, TextureCoordinateIndex, ArraySlice] : renderObject.Model.Textures[mesh->TextureIndex]) {
 							if (Texture) {
 								_objectData.TextureMapInfoArray[i] = {
 									.Descriptor = Texture->GetSRVDescriptor().GetIndex(),
-									.TextureCoordinateIndex = TextureCoordinateIndex
+									.TextureCoordinateIndex = TextureCoordinateIndex,
+									.ArraySlice = ArraySlice
 								};
 							}
 							i++;
 						}
 					}
 
+					// Objects of coarser LODs only differ by their indices
+					for (uint32_t LODIndex = 1; LODIndex < LODCount; LODIndex++) {
+						auto& LODObjectData = objectData[_instanceData.FirstGeometryIndex + LODIndex * geometryCount + geometryIndex];
+						LODObjectData = _objectData;
+						LODObjectData.MeshDescriptors.Indices = mesh->GetIndices(LODIndex)->GetSRVDescriptor(BufferSRVType::Typed);
+					}
+
 					geometryIndex++;
 				}
 			}
@@ -1896,7 +2093,7 @@ private:
 		constexpr auto Key = "ChooseFileDlgKey";
 		IGFD::FileDialogConfig config;
 		config.path = ".";
-		instance.OpenDialog(Key, "Choose File", ".json", config);
+		instance.OpenDialog(Key, "Choose File", ".json,.scenepack", config);
 		if (const auto workSize = ImGui::GetMainViewport()->WorkSize;
 			instance.Display(Key, ImGuiWindowFlags_NoCollapse, { workSize.x / 2, workSize.y / 2 })) {
 			if (instance.IsOk()) {
@@ -1991,6 +2188,38 @@ private:
 					);
 				}
 
+				ImGui::Checkbox("Progressive Scene Loading", &g_graphicsSettings.IsProgressiveSceneLoadingEnabled);
+
+				ImGui::Checkbox("Scene Hot Reload", &g_graphicsSettings.IsSceneHotReloadEnabled);
+
+				// Applies from the next scene loaded; resident assets imported with the other setting are dropped
+				auto isImportChanged = ImGui::Checkbox("Texture Compression", &g_graphicsSettings.IsTextureCompressionEnabled);
+				isImportChanged |= ImGui::Checkbox("Texture Packing", &g_graphicsSettings.IsTexturePackingEnabled);
+				isImportChanged |= ImGui::Checkbox("Vertex Compression", &g_graphicsSettings.IsVertexCompressionEnabled);
+				isImportChanged |= ImGui::Checkbox("Mesh LODs", &g_graphicsSettings.IsMeshLODEnabled);
+				isImportChanged |= ImGui::Checkbox("Texture Streaming", &g_graphicsSettings.IsTextureStreamingEnabled);
+				if (isImportChanged) {
+					m_residentAssetCache.Clear();
+				}
+
+				if (ImGuiEx::TreeNode treeNode("Texture Streaming"); treeNode) {
+					auto& textureStreamingSettings = g_graphicsSettings.TextureStreaming;
+
+					if (ImGui::SliderInt("Budget (MiB)", reinterpret_cast<int*>(&textureStreamingSettings.Budget), 0, textureStreamingSettings.MaxBudget, "%u", ImGuiSliderFlags_AlwaysClamp)) {
+						m_textureStreamer.SetBudget(GetTextureStreamingBudget());
+					}
+				}
+
+				if (ImGuiEx::TreeNode treeNode("Resident Asset Cache"); treeNode) {
+					auto& residentAssetCacheSettings = g_graphicsSettings.ResidentAssetCache;
+
+					auto isChanged = ImGui::SliderInt("CPU Budget (MiB)", reinterpret_cast<int*>(&residentAssetCacheSettings.CPUBudget), 0, residentAssetCacheSettings.MaxBudget, "%u", ImGuiSliderFlags_AlwaysClamp);
+					isChanged |= ImGui::SliderInt("GPU Budget (MiB)", reinterpret_cast<int*>(&residentAssetCacheSettings.GPUBudget), 0, residentAssetCacheSettings.MaxBudget, "%u", ImGuiSliderFlags_AlwaysClamp);
+					if (isChanged) {
+						m_residentAssetCache.SetBudget(GetResidentAssetCacheBudget());
+					}
+				}
+
 				if (ImGuiEx::TreeNode treeNode("Camera", ImGuiTreeNodeFlags_DefaultOpen); treeNode) {
 					auto& cameraSettings = g_graphicsSettings.Camera;
 
@@ -0,0 +1,243 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <Windows.h>
+
+#include <wrl.h>
+
+export module AsyncFileReader;
+
+import ErrorHelpers;
+
+using namespace ErrorHelpers;
+using namespace Microsoft::WRL::Wrappers;
+using namespace std;
+using namespace std::filesystem;
+
+/*
+ * Reads whole files with overlapped I/O, every chunk of every queued file being in flight at once,
+ * and fulfills each future from a completion port thread as soon as the last chunk of its file arrives.
+ * Files that cannot be read this way, or all of them if the completion port is unavailable, are read one by one on a thread of the reader,
+ * not on the thread pool, whose tasks may all be blocked waiting for these very reads.
+ */
+export class AsyncFileReader {
+public:
+	AsyncFileReader(const AsyncFileReader&) = delete;
+	AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+	AsyncFileReader() : m_completionPort(CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1)) {
+		if (m_completionPort.IsValid()) {
+			m_thread = jthread([this] { Run(); });
+		}
+
+		m_fallbackThread = jthread([this](stop_token stopToken) { RunFallback(stopToken); });
+	}
+
+	~AsyncFileReader() {
+		if (m_thread.joinable()) {
+			PostQueuedCompletionStatus(m_completionPort.Get(), 0, ExitKey, nullptr);
+		}
+	}
+
+	// Never destroyed, like the default thread pool, so that reads still pending at exit do not hold it up
+	static AsyncFileReader& GetDefault() {
+		static auto& reader = *new AsyncFileReader;
+		return reader;
+	}
+
+	future<vector<std::byte>> Read(const path& filePath) {
+		auto request = make_unique<Request>();
+		request->FilePath = filePath;
+		auto future = request->Promise.get_future();
+
+		if (!m_thread.joinable() || !Start(request)) {
+			Fallback(move(request));
+		}
+
+		return future;
+	}
+
+	// Queues every read before any of them completes
+	vector<future<vector<std::byte>>> Read(span<const path> filePaths) {
+		vector<future<vector<std::byte>>> futures;
+		futures.reserve(size(filePaths));
+		for (const auto& filePath : filePaths) {
+			futures.emplace_back(Read(filePath));
+		}
+		return futures;
+	}
+
+private:
+	static constexpr ULONG_PTR ExitKey = 1;
+	static constexpr size_t ChunkSize = 4 << 20;
+
+	struct Request;
+
+	struct Chunk : OVERLAPPED {
+		Request* Owner;
+		DWORD Size;
+	};
+
+	struct Request {
+		path FilePath;
+		FileHandle File;
+		vector<std::byte> Data;
+		vector<Chunk> Chunks;
+		atomic_size_t RemainingChunkCount;
+		atomic<DWORD> Error{ ERROR_SUCCESS };
+		promise<vector<std::byte>> Promise;
+	};
+
+	HandleT<HandleTraits::HANDLENullTraits> m_completionPort;
+	jthread m_thread;
+
+	mutex m_fallbackMutex;
+	condition_variable_any m_fallbackCondition;
+	deque<unique_ptr<Request>> m_fallbackRequests;
+	jthread m_fallbackThread;
+
+	// Returns false, leaving request untouched, if the file cannot be read with overlapped I/O
+	bool Start(unique_ptr<Request>& request) {
+		request->File.Attach(CreateFileW(
+			request->FilePath.c_str(),
+			GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+		));
+		LARGE_INTEGER fileSize;
+		if (!request->File.IsValid()
+			|| !GetFileSizeEx(request->File.Get(), &fileSize)
+			|| CreateIoCompletionPort(request->File.Get(), m_completionPort.Get(), 0, 0) == nullptr) {
+			request->File.Close();
+			return false;
+		}
+
+		if (!fileSize.QuadPart) {
+			request->File.Close();
+			request->Promise.set_value({});
+			return true;
+		}
+
+		request->Data.resize(static_cast<size_t>(fileSize.QuadPart));
+		request->Chunks.resize((size(request->Data) + ChunkSize - 1) / ChunkSize);
+		request->RemainingChunkCount = size(request->Chunks);
+
+		// Completions may arrive, and the last one free the request, before this loop ends
+		const auto pRequest = request.release();
+		const auto chunkCount = size(pRequest->Chunks);
+		for (size_t i = 0; i < chunkCount; i++) {
+			auto& chunk = pRequest->Chunks[i];
+			const auto offset = i * ChunkSize;
+			chunk = {};
+			chunk.Offset = static_cast<DWORD>(offset);
+			chunk.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			chunk.Owner = pRequest;
+			chunk.Size = static_cast<DWORD>(min(ChunkSize, size(pRequest->Data) - offset));
+			if (ReadFile(pRequest->File.Get(), data(pRequest->Data) + offset, chunk.Size, nullptr, &chunk)) {
+				continue;
+			}
+			if (const auto error = GetLastError(); error != ERROR_IO_PENDING) {
+				// Chunks that were never issued complete right away with the error
+				for (auto j = i; j < chunkCount; j++) {
+					OnChunkCompleted(pRequest->Chunks[j], error);
+				}
+				break;
+			}
+		}
+		return true;
+	}
+
+	static void OnChunkCompleted(Chunk& chunk, DWORD error) {
+		const auto request = chunk.Owner;
+		if (error != ERROR_SUCCESS) {
+			request->Error = error;
+		}
+		if (--request->RemainingChunkCount) {
+			return;
+		}
+
+		const unique_ptr<Request> owner(request);
+		owner->File.Close();
+		if (const auto requestError = owner->Error.load(); requestError != ERROR_SUCCESS) {
+			try {
+				ThrowSystemError(error_code(static_cast<int>(requestError), system_category()), owner->FilePath.string());
+			}
+			catch (...) {
+				owner->Promise.set_exception(current_exception());
+			}
+		}
+		else {
+			owner->Promise.set_value(move(owner->Data));
+		}
+	}
+
+	void Run() {
+		while (true) {
+			DWORD byteCount;
+			ULONG_PTR key;
+			OVERLAPPED* overlapped;
+			const auto succeeded = GetQueuedCompletionStatus(m_completionPort.Get(), &byteCount, &key, &overlapped, INFINITE);
+			if (overlapped == nullptr) {
+				if (key == ExitKey || !succeeded) {
+					return;
+				}
+				continue;
+			}
+
+			auto& chunk = *static_cast<Chunk*>(overlapped);
+			OnChunkCompleted(chunk, !succeeded ? GetLastError() : byteCount != chunk.Size ? ERROR_HANDLE_EOF : ERROR_SUCCESS);
+		}
+	}
+
+	void Fallback(unique_ptr<Request> request) {
+		{
+			const scoped_lock lock(m_fallbackMutex);
+
+			m_fallbackRequests.emplace_back(move(request));
+		}
+		m_fallbackCondition.notify_one();
+	}
+
+	void RunFallback(stop_token stopToken) {
+		while (true) {
+			unique_ptr<Request> request;
+			{
+				unique_lock lock(m_fallbackMutex);
+
+				if (!m_fallbackCondition.wait(lock, stopToken, [&] { return !empty(m_fallbackRequests); })) {
+					return;
+				}
+				request = move(m_fallbackRequests.front());
+				m_fallbackRequests.pop_front();
+			}
+
+			try {
+				ifstream file(request->FilePath, ios::binary | ios::ate);
+				if (!file) {
+					Throw<runtime_error>(format("{}: Failed to open file", request->FilePath.string()));
+				}
+				vector<std::byte> data(static_cast<size_t>(file.tellg()));
+				file.seekg(0);
+				if (!file.read(reinterpret_cast<char*>(::data(data)), size(data))) {
+					Throw<runtime_error>(format("{}: Failed to read file", request->FilePath.string()));
+				}
+				request->Promise.set_value(move(data));
+			}
+			catch (...) {
+				request->Promise.set_exception(current_exception());
+			}
+		}
+	}
+};
@@ -35,6 +35,12 @@ using namespace std;
 	Copy(buffer, ::data(data), sizeof(T) * size(data), offset);
 
 export namespace DirectX {
+	struct BufferCopy {
+		GPUBuffer& Buffer;
+		const void* Data;
+		size_t Size;
+	};
+
 	class CommandList {
 	public:
 		CommandList(const CommandList&) = delete;
@@ -152,6 +158,13 @@ export namespace DirectX {
 			m_trackedAllocations.emplace_back(allocation);
 		}
 
+		void Copy(Texture& destination, UINT destinationSubresource, Texture& source, UINT sourceSubresource) {
+			SetState(destination, D3D12_RESOURCE_STATE_COPY_DEST);
+			SetState(source, D3D12_RESOURCE_STATE_COPY_SOURCE);
+			const CD3DX12_TEXTURE_COPY_LOCATION destinationLocation(destination, destinationSubresource), sourceLocation(source, sourceSubresource);
+			(*this)->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, nullptr);
+		}
+
 		void Clear(GPUBuffer& buffer, UINT value = 0) {
 			SetState(buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 			(*this)->ClearUnorderedAccessViewUint(buffer.GetUAVDescriptor(BufferUAVType::Raw), buffer.GetUAVDescriptor(BufferUAVType::Clear), buffer, data(initializer_list{ value, value, value, value }), 0, nullptr);
@@ -193,6 +206,46 @@ export namespace DirectX {
 			m_trackedAllocations.emplace_back(allocation);
 		}
 
+		// Uploads several buffers through a single staging allocation
+		void Copy(span<const BufferCopy> copies) {
+			UINT64 uploadSize = 0;
+			for (const auto& [Buffer, pData, Size] : copies) {
+				if (Buffer.IsMappable()) {
+					memcpy(Buffer.GetMappedData(), pData, Size);
+				}
+				else {
+					uploadSize = AlignUp(uploadSize, 16) + Size;
+				}
+			}
+			if (!uploadSize) {
+				return;
+			}
+
+			const auto allocation = CreateUploadBuffer(uploadSize);
+			const auto resource = allocation->GetResource();
+
+			constexpr D3D12_RANGE range{};
+			void* data;
+			ThrowIfFailed(resource->Map(0, &range, &data));
+
+			UINT64 offset = 0;
+			for (const auto& [Buffer, pData, Size] : copies) {
+				if (Buffer.IsMappable()) {
+					continue;
+				}
+
+				offset = AlignUp(offset, 16);
+				memcpy(static_cast<uint8_t*>(data) + offset, pData, Size);
+
+				SetState(Buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+				(*this)->CopyBufferRegion(Buffer, 0, resource, offset, Size);
+
+				offset += Size;
+			}
+
+			m_trackedAllocations.emplace_back(allocation);
+		}
+
 		template <typename T>
 		void Copy(GPUBuffer& buffer, initializer_list<T> data, size_t offset = 0) { COPY(); }
 
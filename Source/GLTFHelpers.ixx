@@ -1,8 +1,14 @@
 module;
 
 #include <array>
+#include <bit>
+#include <cstring>
 #include <filesystem>
+#include <future>
+#include <mutex>
 #include <ranges>
+#include <span>
+#include <unordered_map>
 
 #include <d3d12.h>
 
@@ -11,20 +17,29 @@ module;
 
 #include "DirectXMesh.h"
 
+#include "DirectXTex.h"
+
+#include "meshoptimizer.h"
+
 #include "directxtk12/SimpleMath.h"
 
 export module GLTFHelpers;
 
 export import Animation;
+import AsyncFileReader;
 import CommandList;
-import DeviceContext;
 import ErrorHelpers;
-import GPUBuffer;
 import Material;
+import MemoryMappedFile;
+import MeshOptimization;
 export import Model;
+export import ModelData;
 import Math;
+import MipChainGeneration;
 import ResourceHelpers;
+import TextureCompression;
 import TextureHelpers;
+import ThreadHelpers;
 
 using namespace DirectX;
 using namespace DirectX::PackedVector;
@@ -35,230 +50,448 @@ using namespace ResourceHelpers;
 using namespace std;
 using namespace std::filesystem;
 using namespace TextureHelpers;
+using namespace ThreadHelpers;
 
-namespace {
-	auto Load(
-		const path& filePath,
-		fastgltf::Category category = fastgltf::Category::All,
-		fastgltf::Options options = fastgltf::Options::None,
-		fastgltf::Extensions extensions = fastgltf::Extensions::None
-	) {
-		const auto ThrowIfFailed = [&](fastgltf::Error error) {
-			if (error != fastgltf::Error::None) {
-				throw runtime_error(format("{}: {}", filePath.string(), getErrorMessage(error)));
+export namespace GLTFHelpers {
+	struct ParsedAsset {
+		path FilePath;
+
+		fastgltf::Asset Asset;
+
+		ParsedAsset(const ParsedAsset&) = delete;
+		ParsedAsset& operator=(const ParsedAsset&) = delete;
+
+		ParsedAsset(
+			const path& filePath,
+			fastgltf::Category category = fastgltf::Category::All,
+			fastgltf::Options options = fastgltf::Options::None,
+			fastgltf::Extensions extensions = fastgltf::Extensions::None,
+			bool isMemoryMapped = true
+		) noexcept(false) : FilePath(filePath) {
+			const auto ThrowIfFailed = [&](fastgltf::Error error) {
+				if (error != fastgltf::Error::None) {
+					throw runtime_error(format("{}: {}", filePath.string(), getErrorMessage(error)));
+				}
+			};
+
+			// Reading the file and its buffers into memory is what loads did before they were mapped, kept for comparison
+			if (isMemoryMapped) {
+				auto file = fastgltf::MappedGltfFile::FromPath(filePath);
+				ThrowIfFailed(file.error());
+				m_file = make_unique<fastgltf::MappedGltfFile>(move(file.get()));
 			}
-		};
-		auto data = fastgltf::GltfDataBuffer::FromPath(filePath);
-		ThrowIfFailed(data.error());
-		fastgltf::Parser parser(extensions);
-		auto asset = parser.loadGltf(
-			data.get(),
-			filePath.parent_path(),
-			options | fastgltf::Options::LoadExternalBuffers,
-			category
-		);
-		ThrowIfFailed(asset.error());
-		return *move(asset);
-	}
+			else {
+				auto file = fastgltf::GltfDataBuffer::FromPath(filePath);
+				ThrowIfFailed(file.error());
+				m_file = make_unique<fastgltf::GltfDataBuffer>(move(file.get()));
+				options = options | fastgltf::Options::LoadExternalBuffers;
+			}
+
+			const auto directoryPath = filePath.parent_path();
+
+			fastgltf::Parser parser(extensions);
+			auto asset = parser.loadGltf(*m_file, directoryPath, options, category);
+			ThrowIfFailed(asset.error());
+			Asset = move(asset.get());
+
+			// External buffer files are mapped once however many buffers they hold, and prefetched as soon as they are,
+			// so that their pages stay reclaimable and their reads overlap instead of being faulted in one by one
+			unordered_map<path, const MemoryMappedFile*> externalFiles;
+
+			m_buffers.reserve(size(Asset.buffers));
+			for (const auto& buffer : Asset.buffers) {
+				auto& data = m_buffers.emplace_back();
+				if (const auto array = get_if<fastgltf::sources::Array>(&buffer.data); array != nullptr) {
+					data = array->bytes;
+				}
+				else if (const auto vector = get_if<fastgltf::sources::Vector>(&buffer.data); vector != nullptr) {
+					data = vector->bytes;
+				}
+				else if (const auto byteView = get_if<fastgltf::sources::ByteView>(&buffer.data); byteView != nullptr) {
+					data = byteView->bytes;
+				}
+				else if (const auto URI = get_if<fastgltf::sources::URI>(&buffer.data);
+					URI != nullptr && URI->uri.isLocalPath()) {
+					const auto bufferFilePath = (directoryPath / URI->uri.path()).lexically_normal();
+					auto& file = externalFiles[bufferFilePath];
+					if (file == nullptr) {
+						file = m_externalFiles.emplace_back(make_unique<MemoryMappedFile>(bufferFilePath)).get();
+						file->Prefetch();
+					}
+					const auto fileData = file->GetData();
+					if (URI->fileByteOffset + buffer.byteLength > size(fileData)) {
+						throw runtime_error(format("{}: Buffer out of range", bufferFilePath.string()));
+					}
+					data = fileData.subspan(URI->fileByteOffset, buffer.byteLength);
+				}
+			}
+
+			DecompressBufferViews();
+		}
+
+		// Resolves buffer views against the mapped files, so that accessors are read in place
+		span<const std::byte> operator()(const fastgltf::Asset& asset, size_t bufferViewIndex) const {
+			if (const auto& data = m_decompressedBufferViews.at(bufferViewIndex); !empty(data)) {
+				return data;
+			}
+
+			const auto& bufferView = asset.bufferViews.at(bufferViewIndex);
+			const auto data = m_buffers.at(bufferView.bufferIndex);
+			if (bufferView.byteOffset + bufferView.byteLength > size(data)) {
+				throw out_of_range("Buffer view out of range");
+			}
+			return data.subspan(bufferView.byteOffset, bufferView.byteLength);
+		}
+
+	private:
+		unique_ptr<fastgltf::GltfDataGetter> m_file;
+		vector<unique_ptr<MemoryMappedFile>> m_externalFiles;
+		vector<span<const std::byte>> m_buffers;
+		vector<vector<std::byte>> m_decompressedBufferViews;
+
+		// EXT_meshopt_compression
+		void DecompressBufferViews() {
+			m_decompressedBufferViews.resize(size(Asset.bufferViews));
+
+			vector<size_t> bufferViewIndices;
+			for (size_t i = 0; const auto & bufferView : Asset.bufferViews) {
+				if (bufferView.meshoptCompression) {
+					bufferViewIndices.emplace_back(i);
+				}
+				i++;
+			}
+
+			ParallelFor(size(bufferViewIndices), [&](size_t i) {
+				const auto index = bufferViewIndices[i];
+				const auto& compression = *Asset.bufferViews[index].meshoptCompression;
+
+				const auto bufferData = m_buffers.at(compression.bufferIndex);
+				if (compression.byteOffset + compression.byteLength > size(bufferData)) {
+					throw runtime_error(format("{}: Compressed buffer view out of range", FilePath.string()));
+				}
+				const auto source = reinterpret_cast<const unsigned char*>(data(bufferData) + compression.byteOffset);
+
+				auto& destination = m_decompressedBufferViews[index];
+				destination.resize(compression.count * compression.byteStride);
+
+				int result = -1;
+				switch (compression.mode) {
+					case fastgltf::MeshoptCompressionMode::Attributes:
+						result = meshopt_decodeVertexBuffer(data(destination), compression.count, compression.byteStride, source, compression.byteLength);
+						break;
+
+					case fastgltf::MeshoptCompressionMode::Triangles:
+						result = meshopt_decodeIndexBuffer(data(destination), compression.count, compression.byteStride, source, compression.byteLength);
+						break;
+
+					case fastgltf::MeshoptCompressionMode::Indices:
+						result = meshopt_decodeIndexSequence(data(destination), compression.count, compression.byteStride, source, compression.byteLength);
+						break;
+				}
+				if (result) {
+					throw runtime_error(format("{}: Failed to decompress buffer view {}", FilePath.string(), index));
+				}
+
+				switch (compression.filter) {
+					case fastgltf::MeshoptCompressionFilter::Octahedral:
+						meshopt_decodeFilterOct(data(destination), compression.count, compression.byteStride);
+						break;
+
+					case fastgltf::MeshoptCompressionFilter::Quaternion:
+						meshopt_decodeFilterQuat(data(destination), compression.count, compression.byteStride);
+						break;
+
+					case fastgltf::MeshoptCompressionFilter::Exponential:
+						meshopt_decodeFilterExp(data(destination), compression.count, compression.byteStride);
+						break;
+				}
+			});
+		}
+	};
+}
+
+namespace {
+	using GLTFHelpers::ParsedAsset;
+
+	const auto
+		g_modelCategory = fastgltf::Category::OnlyRenderable | fastgltf::Category::Skins,
+		g_animationCategory = fastgltf::Category::OnlyAnimations | fastgltf::Category::Nodes | fastgltf::Category::Scenes;
+
+	const auto
+		g_modelOptions = fastgltf::Options::GenerateMeshIndices,
+		g_animationOptions = fastgltf::Options::DecomposeNodeMatrices;
+
+	const auto g_modelExtensions = fastgltf::Extensions::MSFT_texture_dds
+		| fastgltf::Extensions::KHR_materials_emissive_strength
+		| fastgltf::Extensions::KHR_materials_ior
+		| fastgltf::Extensions::KHR_materials_transmission
+		| fastgltf::Extensions::KHR_mesh_quantization
+		| fastgltf::Extensions::EXT_meshopt_compression
+		| fastgltf::Extensions::KHR_texture_basisu;
 
 	auto GetDefaultSceneIndex(const fastgltf::Asset& asset) {
 		return clamp<size_t>(asset.defaultScene ? asset.defaultScene.value() : 0, 0, size(asset.scenes));
 	}
 
-	struct StoredSkinJoints {
+	struct StoredSkin {
 		size_t Index;
-		shared_ptr<vector<SkinJoint>> SkinJoints;
+		uint32_t SkinIndex;
 	};
 
-	struct LoadedTexture {
-		const void* Data;
+	// Image referenced by the model, registered in glTF order and decoded afterwards in parallel
+	struct TextureSource {
+		// For image files, filled in once the file has been read
+		span<const std::byte> Data;
+		fastgltf::MimeType MimeType;
 		path FilePath;
-		shared_ptr<Texture> Resource;
+		// Block-compressed format the image is transcoded or compressed to, unknown to keep it as decoded
+		DXGI_FORMAT CompressedFormat;
+		bool ForceSRGB;
+		MipChainDesc MipChain;
+		uint32_t ImageIndex;
 
 		bool IsSameAs(const path& filePath) const { return FilePath == filePath || AreSamePath(FilePath, filePath); }
 	};
 
-	void LoadTexture(
-		const path& directoryPath, const fastgltf::Asset& asset, const fastgltf::TextureInfo& textureInfo,
-		bool forceSRGB, shared_ptr<Texture>& texture, vector<LoadedTexture>& loadedTextures,
-		CommandList& commandList
+	uint32_t AddTexture(
+		const ParsedAsset& parsedAsset, const fastgltf::TextureInfo& textureInfo, uint32_t textureMapType,
+		bool forceSRGB, bool compress, const MipChainDesc& mipChain, ModelData& modelData, vector<TextureSource>& textureSources
 	) {
+		const auto& asset = parsedAsset.Asset;
+
 		size_t imageIndex;
 		if (const auto& texture = asset.textures.at(textureInfo.textureIndex);
-			texture.ddsImageIndex) {
+			texture.basisuImageIndex) {
+			imageIndex = texture.basisuImageIndex.value();
+		}
+		else if (texture.ddsImageIndex) {
 			imageIndex = texture.ddsImageIndex.value();
 		}
 		else if (texture.imageIndex) {
 			imageIndex = texture.imageIndex.value();
 		}
 		else {
-			return;
+			return ~0u;
 		}
 
-		const auto Load = [&](span<const std::byte> data, fastgltf::MimeType mimeType) {
-			if (const auto pLoadedTexture = ranges::find_if(loadedTextures, [&](const auto& value) {
-				return value.Data == ::data(data);
+		const auto Add = [&](span<const std::byte> data, fastgltf::MimeType mimeType, const path& filePath) {
+			// KTX2 images are always transcoded, and other images compressed if requested, to the format that matches the texture map type
+			const auto isKTX2 = mimeType == fastgltf::MimeType::KTX2 || (!empty(filePath) && !_wcsicmp(filePath.extension().c_str(), L".ktx2"));
+			const auto compressedFormat = isKTX2 || compress ? GetBlockCompressedFormat(textureMapType) : DXGI_FORMAT_UNKNOWN;
+			if (const auto pTextureSource = ranges::find_if(textureSources, [&](const auto& value) {
+				return (empty(filePath) ? value.Data.data() == ::data(data) : value.IsSameAs(filePath))
+					&& value.CompressedFormat == compressedFormat && value.MipChain == mipChain;
 				});
-				pLoadedTexture == cend(loadedTextures)) {
-				const auto format = mimeType == fastgltf::MimeType::DDS ? "dds" : "";
-				texture = ::LoadTexture(commandList, format, data, forceSRGB);
-				texture->CreateSRV();
-
-				loadedTextures.emplace_back(::data(data), "", texture);
-			}
-			else {
-				texture = pLoadedTexture->Resource;
+				pTextureSource != cend(textureSources)) {
+				return pTextureSource->ImageIndex;
 			}
+
+			const auto index = static_cast<uint32_t>(size(modelData.Images));
+			modelData.Images.emplace_back(nullptr, textureMapType);
+			textureSources.emplace_back(data, isKTX2 ? fastgltf::MimeType::KTX2 : mimeType, filePath, compressedFormat, forceSRGB, mipChain, index);
+			return index;
 		};
 		const auto& image = asset.images.at(imageIndex);
 		if (const auto view = get_if<fastgltf::sources::BufferView>(&image.data); view != nullptr) {
-			const auto& bufferView = asset.bufferViews.at(view->bufferViewIndex);
-			const auto& buffer = asset.buffers.at(bufferView.bufferIndex);
-			if (const auto array = get_if<fastgltf::sources::Array>(&buffer.data); array != nullptr) {
-				Load(span(data(array->bytes) + bufferView.byteOffset, bufferView.byteLength), array->mimeType);
-			}
+			return Add(parsedAsset(asset, view->bufferViewIndex), view->mimeType, {});
 		}
-		else if (const auto array = get_if<fastgltf::sources::Array>(&image.data); array != nullptr) {
-			Load(array->bytes, array->mimeType);
+		if (const auto array = get_if<fastgltf::sources::Array>(&image.data); array != nullptr) {
+			return Add(array->bytes, array->mimeType, {});
 		}
-		else if (const auto URI = get_if<fastgltf::sources::URI>(&image.data);
+		if (const auto URI = get_if<fastgltf::sources::URI>(&image.data);
 			URI != nullptr && !URI->fileByteOffset && URI->uri.isLocalPath()) {
-			const auto filePath = directoryPath / URI->uri.path();
-			if (const auto pLoadedTexture = ranges::find_if(loadedTextures, [&](const auto& value) {
-				return value.IsSameAs(filePath);
-				});
-				pLoadedTexture == cend(loadedTextures)) {
-				texture = ::LoadTexture(commandList, filePath, forceSRGB);
-				texture->CreateSRV();
+			return Add({}, URI->mimeType, parsedAsset.FilePath.parent_path() / URI->uri.path());
+		}
+		return ~0u;
+	}
+
+	// Keys the encoded image together with the decode settings, so that identical files shipped by different models compare equal
+	TextureKey GetKey(const TextureSource& textureSource) {
+		const auto& [Data, MimeType, FilePath, CompressedFormat, ForceSRGB, MipChain, _] = textureSource;
+
+		const auto settings = (static_cast<uint64_t>(bit_cast<uint32_t>(MipChain.AlphaCutoff)) << 32)
+			| (static_cast<uint64_t>(MipChain.IsNormalMap) << 16) | (static_cast<uint64_t>(CompressedFormat) << 1) | ForceSRGB;
+		if (!empty(Data) || empty(FilePath)) {
+			return GetTextureKey(Data, settings);
+		}
+		return GetTextureKey(MemoryMappedFile(FilePath).GetData(), settings);
+	}
 
-				loadedTextures.emplace_back(nullptr, filePath, texture);
+	// Block-compressed results are cached in cacheDirectoryPath if it is not empty, under textureKey
+	shared_ptr<ScratchImage> DecodeTexture(const TextureSource& textureSource, const TextureKey& textureKey = {}, const path& cacheDirectoryPath = {}) {
+		const auto& [Data, MimeType, FilePath, CompressedFormat, ForceSRGB, MipChain, _] = textureSource;
+
+		const auto Decode = [&](ScratchImage& image) {
+			if (MimeType == fastgltf::MimeType::KTX2) {
+				if (!empty(Data) || empty(FilePath)) {
+					DecodeKTX2(image, Data, CompressedFormat);
+				}
+				else {
+					DecodeKTX2(image, FilePath, CompressedFormat);
+				}
+				if (ForceSRGB) {
+					image.OverrideFormat(MakeSRGB(image.GetMetadata().format));
+				}
+				return;
+			}
+
+			if (empty(FilePath)) {
+				::DecodeTexture(image, MimeType == fastgltf::MimeType::DDS ? "dds" : "", Data, ForceSRGB);
+			}
+			else if (!empty(Data)) {
+				const auto extension = FilePath.extension().string();
+				::DecodeTexture(image, empty(extension) ? "" : string_view(extension).substr(1), Data, ForceSRGB);
 			}
 			else {
-				texture = pLoadedTexture->Resource;
+				::DecodeTexture(image, FilePath, ForceSRGB);
 			}
+			GenerateMipChain(image, MipChain);
+			if (CompressedFormat != DXGI_FORMAT_UNKNOWN) {
+				// Import-time compression trades some BC7 quality for speed, scene packs are cooked at full quality
+				CompressTexture(image, CompressedFormat, TEX_COMPRESS_BC7_QUICK);
+			}
+		};
+
+		const auto image = make_shared<ScratchImage>();
+		if (textureKey && CompressedFormat != DXGI_FORMAT_UNKNOWN) {
+			LoadCachedTexture(*image, textureKey, cacheDirectoryPath, Decode);
+		}
+		else {
+			Decode(*image);
 		}
+		return image;
 	}
 
-	shared_ptr<Mesh> ProcessPrimitive(
-		const path& directoryPath,
-		const fastgltf::Asset& asset, const fastgltf::Primitive& primitive,
+	// Decodes the geometry of a primitive, touching nothing outside of meshData so that primitives can be decoded in parallel
+	bool DecodePrimitive(
+		const ParsedAsset& parsedAsset, const fastgltf::Primitive& primitive,
 		bool flipWindingOrder,
-		Model& model,
-		vector<LoadedTexture>& loadedTextures,
-		CommandList& commandList
+		MeshData& meshData
 	) {
 		if (primitive.type != fastgltf::PrimitiveType::Triangles) {
-			return nullptr;
+			return false;
 		}
 
-		vector<Mesh::VertexType> vertices;
-		if (const auto attribute = primitive.findAttribute("POSITION"); attribute != cend(primitive.attributes)) {
-			const auto& accessor = asset.accessors.at(attribute->accessorIndex);
-			vertices.reserve(accessor.count);
-			fastgltf::iterateAccessor<XMFLOAT3>(
-				asset, accessor,
-				[&](const XMFLOAT3& value) {
-					vertices.emplace_back(Mesh::VertexType{ .Position = value });
-				}
-			);
+		const auto& asset = parsedAsset.Asset;
+
+		const auto FindAccessor = [&](string_view name) -> const fastgltf::Accessor* {
+			const auto attribute = primitive.findAttribute(name);
+			return attribute == cend(primitive.attributes) ? nullptr : &asset.accessors.at(attribute->accessorIndex);
+		};
+
+		// Every destination is sized once from its accessor and written in place, so no attribute is appended or copied twice
+		const auto positionAccessor = FindAccessor("POSITION");
+		if (positionAccessor == nullptr || !primitive.indicesAccessor) {
+			return false;
 		}
-		else {
-			return nullptr;
-		}
-
-		vector<uint8_t> indices;
-		size_t indexStride;
-		if (primitive.indicesAccessor) {
-			const auto& accessor = asset.accessors[primitive.indicesAccessor.value()];
-			const auto Iterate = [&]<typename T> {
-				indexStride = sizeof(T);
-				indices.resize(accessor.count* indexStride);
-				fastgltf::iterateAccessorWithIndex<T>(
-					asset, accessor,
-					[&](T value, size_t index) {
-						reinterpret_cast<T*>(data(indices))[flipWindingOrder ? accessor.count - 1 - index : index] = value;
-					}
-				);
-			};
-			if (accessor.count <= UINT16_MAX) {
-				Iterate.operator() < uint16_t > ();
-			}
-			else {
-				Iterate.operator() < uint32_t > ();
+		const auto vertexCount = positionAccessor->count;
+
+		const auto normalAccessor = FindAccessor("NORMAL"), tangentAccessor = FindAccessor("Tangent");
+		const fastgltf::Accessor* textureCoordinateAccessors[]{ FindAccessor("TEXCOORD_0"), FindAccessor("TEXCOORD_1") };
+		const auto jointAccessor = FindAccessor("JOINTS_0"), weightAccessor = jointAccessor == nullptr ? nullptr : FindAccessor("WEIGHTS_0");
+		for (const auto accessor : { normalAccessor, tangentAccessor, textureCoordinateAccessors[0], textureCoordinateAccessors[1], jointAccessor, weightAccessor }) {
+			if (accessor != nullptr && accessor->count != vertexCount) {
+				return false;
 			}
 		}
-		else {
-			return nullptr;
-		}
 
-		const auto normalAttribute = primitive.findAttribute("NORMAL"), tangentAttribute = primitive.findAttribute("Tangent");
+		auto& vertices = meshData.Vertices;
+		vertices.resize(vertexCount);
 
+		// Tangent frames are computed from full-precision attributes, which are staged in a single allocation
+		const auto shouldComputeTangents = normalAccessor != nullptr && tangentAccessor == nullptr && textureCoordinateAccessors[0] != nullptr;
+		vector<XMFLOAT3> tangentFrameData;
 		vector<XMFLOAT2> textureCoordinates;
-		bool hasTextureCoordinates[2]{};
+		XMFLOAT3* positions = nullptr, * normals = nullptr, * tangents = nullptr;
+		if (shouldComputeTangents) {
+			tangentFrameData.resize(vertexCount * 3);
+			textureCoordinates.resize(vertexCount);
+			positions = data(tangentFrameData);
+			normals = positions + vertexCount;
+			tangents = normals + vertexCount;
+		}
+
+		fastgltf::iterateAccessorWithIndex<XMFLOAT3>(
+			asset, *positionAccessor,
+			[&](const XMFLOAT3& value, size_t index) {
+				vertices[index].Position = value;
+
+				if (positions != nullptr) {
+					positions[index] = value;
+				}
+			},
+			parsedAsset
+		);
+
+		const auto& indexAccessor = asset.accessors.at(primitive.indicesAccessor.value());
+		const auto indexStride = vertexCount <= UINT16_MAX ? sizeof(uint16_t) : sizeof(uint32_t);
+		meshData.IndexFormat = indexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		meshData.Indices.resize(indexAccessor.count * indexStride);
+		const auto IterateIndices = [&]<typename T> {
+			const auto indices = reinterpret_cast<T*>(data(meshData.Indices));
+			fastgltf::iterateAccessorWithIndex<T>(
+				asset, indexAccessor,
+				[&](T value, size_t index) { indices[flipWindingOrder ? indexAccessor.count - 1 - index : index] = value; },
+				parsedAsset
+			);
+		};
+		if (indexStride == sizeof(uint16_t)) {
+			IterateIndices.operator() < uint16_t > ();
+		}
+		else {
+			IterateIndices.operator() < uint32_t > ();
+		}
+
 		for (const auto i : { 0, 1 }) {
-			if (const auto attribute = primitive.findAttribute(format("TEXCOORD_{}", i));
-				attribute != cend(primitive.attributes)) {
-				const auto shouldStoreTextureCoordinates = !i
-					&& normalAttribute != cend(primitive.attributes) && tangentAttribute == cend(primitive.attributes);
+			if (const auto accessor = textureCoordinateAccessors[i]; accessor != nullptr) {
 				fastgltf::iterateAccessorWithIndex<XMFLOAT2>(
-					asset, asset.accessors.at(attribute->accessorIndex),
+					asset, *accessor,
 					[&](const XMFLOAT2& value, size_t index) {
 						vertices[index].StoreTextureCoordinate(value, i);
 
-				if (shouldStoreTextureCoordinates) {
-					if (empty(textureCoordinates)) {
-						textureCoordinates.reserve(size(vertices));
-					}
-					textureCoordinates.emplace_back(value);
-				}
-					}
+						if (!i && shouldComputeTangents) {
+							textureCoordinates[index] = value;
+						}
+					},
+					parsedAsset
 				);
 
-				hasTextureCoordinates[i] = true;
+				meshData.HasTextureCoordinates[i] = true;
 			}
 		}
 
-		auto hasNormals = false, hasTangents = false;
-		if (normalAttribute != cend(primitive.attributes)) {
-			vector<XMFLOAT3> normals;
-			const auto shouldStoreNormals = !empty(textureCoordinates) && tangentAttribute == cend(primitive.attributes);
+		if (normalAccessor != nullptr) {
 			fastgltf::iterateAccessorWithIndex<XMFLOAT3>(
-				asset, asset.accessors.at(normalAttribute->accessorIndex),
+				asset, *normalAccessor,
 				[&](const XMFLOAT3& value, size_t index) {
 					vertices[index].StoreNormal(value);
 
-			if (shouldStoreNormals) {
-				if (empty(normals)) {
-					normals.reserve(size(vertices));
-				}
-				normals.emplace_back(value);
-			}
-				}
+					if (normals != nullptr) {
+						normals[index] = value;
+					}
+				},
+				parsedAsset
 			);
 
-			hasNormals = true;
+			meshData.HasNormals = true;
 
-			if (tangentAttribute != cend(primitive.attributes)) {
+			if (tangentAccessor != nullptr) {
 				fastgltf::iterateAccessorWithIndex<XMFLOAT4>(
-					asset, asset.accessors.at(tangentAttribute->accessorIndex),
+					asset, *tangentAccessor,
 					[&](const XMFLOAT4& value, size_t index) {
 						vertices[index].StoreTangent(reinterpret_cast<const XMFLOAT3&>(value));
-					}
+					},
+					parsedAsset
 				);
 
-				hasTangents = true;
+				meshData.HasTangents = true;
 			}
-			else if (!empty(textureCoordinates)) {
-				vector<XMFLOAT3> positions, tangents(size(vertices));
-				positions.reserve(size(vertices));
-				for (const auto& vertex : vertices) {
-					positions.emplace_back(vertex.Position);
-				}
+			else if (shouldComputeTangents) {
 				const auto ComputeTangentFrame = [&]<typename T> {
 					ThrowIfFailed(::ComputeTangentFrame(
-						reinterpret_cast<const T*>(data(indices)), size(indices) / 3 / indexStride,
-						data(positions), data(normals), data(textureCoordinates), size(vertices),
-						data(tangents), nullptr
+						reinterpret_cast<const T*>(data(meshData.Indices)), size(meshData.Indices) / 3 / indexStride,
+						positions, normals, data(textureCoordinates), vertexCount,
+						tangents, nullptr
 					));
 				};
 				if (indexStride == sizeof(uint16_t)) {
@@ -267,90 +500,59 @@ namespace {
 				else {
 					ComputeTangentFrame.operator() < uint32_t > ();
 				}
-				for (size_t i = 0; const auto & tangent : tangents) {
-					vertices[i++].StoreTangent(tangent);
+				for (size_t i = 0; i < vertexCount; i++) {
+					vertices[i].StoreTangent(tangents[i]);
 				}
 
-				hasTangents = true;
+				meshData.HasTangents = true;
 			}
 		}
 
-		auto hasJoints = false;
-		vector<Mesh::SkeletalVertexType> skeletalVertices;
-		if (const auto attribute = primitive.findAttribute("JOINTS_0"); attribute != cend(primitive.attributes)) {
-			skeletalVertices.reserve(size(vertices));
-			fastgltf::iterateAccessor<fastgltf::math::u16vec4>(
-				asset, asset.accessors.at(attribute->accessorIndex),
-				[&](const fastgltf::math::u16vec4& value) {
-					skeletalVertices.emplace_back(Mesh::SkeletalVertexType{ .Joints = reinterpret_cast<const XMUSHORT4&>(value) });
-				}
-			);
+		if (weightAccessor != nullptr) {
+			auto& skeletalVertices = meshData.SkeletalVertices;
+			skeletalVertices.resize(vertexCount);
 
-			if (const auto attribute = primitive.findAttribute("WEIGHTS_0"); attribute != cend(primitive.attributes)) {
-				fastgltf::iterateAccessorWithIndex<XMFLOAT4>(
-					asset, asset.accessors.at(attribute->accessorIndex),
-					[&](const XMFLOAT4& value, size_t index) {
-						auto& skeletalVertex = skeletalVertices[index];
-				skeletalVertex.Weights = value;
+			fastgltf::iterateAccessorWithIndex<fastgltf::math::u16vec4>(
+				asset, *jointAccessor,
+				[&](const fastgltf::math::u16vec4& value, size_t index) {
+					skeletalVertices[index].Joints = reinterpret_cast<const XMUSHORT4&>(value);
+				},
+				parsedAsset
+			);
 
-				const auto& vertex = vertices[index];
-				skeletalVertex.Position = vertex.Position;
-				skeletalVertex.Normal = vertex.Normal;
-				skeletalVertex.Tangent = vertex.Tangent;
-					}
-				);
-				hasJoints = true;
-			}
+			fastgltf::iterateAccessorWithIndex<XMFLOAT4>(
+				asset, *weightAccessor,
+				[&](const XMFLOAT4& value, size_t index) {
+					auto& skeletalVertex = skeletalVertices[index];
+					skeletalVertex.Weights = value;
+
+					const auto& vertex = vertices[index];
+					skeletalVertex.Position = vertex.Position;
+					skeletalVertex.Normal = vertex.Normal;
+					skeletalVertex.Tangent = vertex.Tangent;
+				},
+				parsedAsset
+			);
 		}
 
-		const auto mesh = make_shared<Mesh>();
-
-		mesh->HasNormals = hasNormals;
-		mesh->HasTangents = hasTangents;
-		ranges::copy(hasTextureCoordinates, mesh->HasTextureCoordinates);
-
-		const auto& deviceContext = commandList.GetDeviceContext();
-
-		{
-			const auto CreateBuffer = [&](auto& buffer, const auto& data, bool isStructuredSRV = true, bool hasSRV = true) {
-				using T = typename remove_cvref_t<decltype(data)>::value_type;
-				const auto format = &buffer == &mesh->Indices ?
-					(indexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT) : DXGI_FORMAT_UNKNOWN;
-				buffer = GPUBuffer::CreateDefault<T>(deviceContext, size(data), format);
-				if (hasSRV) {
-					buffer->CreateSRV(
-						format == DXGI_FORMAT_UNKNOWN ?
-						(isStructuredSRV ? BufferSRVType::Structured : BufferSRVType::Raw) : BufferSRVType::Typed
-					);
-				}
-				if (::data(data) != nullptr) {
-					commandList.Copy(*buffer, data);
-				}
-				commandList.SetState(*buffer, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
-			};
-
-			CreateBuffer(mesh->Vertices, vertices, false);
-
-			if (const auto size = ::size(indices) / indexStride;
-				indexStride == sizeof(uint16_t)) {
-				CreateBuffer(mesh->Indices, span(reinterpret_cast<const uint16_t*>(data(indices)), size));
-			}
-			else {
-				CreateBuffer(mesh->Indices, span(reinterpret_cast<const uint32_t*>(data(indices)), size));
-			}
+		return true;
+	}
 
-			if (hasJoints) {
-				CreateBuffer(mesh->SkeletalVertices, skeletalVertices, false, false);
-				CreateBuffer(mesh->MotionVectors, span(static_cast<const Mesh::MotionVectorType*>(nullptr), size(vertices)));
-			}
-		}
+	void DecodeMaterial(
+		const ParsedAsset& parsedAsset, const fastgltf::Primitive& primitive,
+		MeshData& meshData,
+		ModelData& modelData,
+		vector<TextureSource>& textureSources,
+		bool compressTextures
+	) {
+		const auto& asset = parsedAsset.Asset;
 
 		if (primitive.materialIndex) {
-			mesh->MaterialIndex = static_cast<uint32_t>(size(model.Materials));
+			meshData.MaterialIndex = static_cast<uint32_t>(size(modelData.Materials));
 
 			const auto& material = asset.materials.at(primitive.materialIndex.value());
 
-			auto& _material = model.Materials.emplace_back(Material{
+			auto& _material = modelData.Materials.emplace_back(Material{
 				.BaseColor = reinterpret_cast<const XMFLOAT4&>(material.pbrData.baseColorFactor),
 				.EmissiveStrength = material.emissiveStrength,
 				.EmissiveColor = reinterpret_cast<const XMFLOAT3&>(material.emissiveFactor),
@@ -364,19 +566,23 @@ namespace {
 				_material.Transmission = material.transmission->transmissionFactor;
 			}
 
-			if (hasTextureCoordinates[0] || hasTextureCoordinates[1]) {
-				mesh->TextureIndex = static_cast<uint32_t>(size(model.Textures));
+			if (meshData.HasTextureCoordinates[0] || meshData.HasTextureCoordinates[1]) {
+				meshData.TextureIndex = static_cast<uint32_t>(size(modelData.Textures));
 
-				for (auto& textures = model.Textures.emplace_back();
+				for (auto& textures = modelData.Textures.emplace_back();
 					const auto i : views::iota(0u, static_cast<uint32_t>(TextureMapType::Count))) {
 					const fastgltf::TextureInfo* textureInfo = nullptr;
 					auto forceSRGB = false;
+					MipChainDesc mipChain;
 					switch (i) {
 						case TextureMapType::BaseColor:
 						{
 							if (material.pbrData.baseColorTexture) {
 								textureInfo = &material.pbrData.baseColorTexture.value();
 								forceSRGB = true;
+								if (material.alphaMode == fastgltf::AlphaMode::Mask) {
+									mipChain.AlphaCutoff = material.alphaCutoff;
+								}
 							}
 						}
 						break;
@@ -408,144 +614,298 @@ namespace {
 
 						case TextureMapType::Normal:
 						{
-							if (hasTangents && material.normalTexture) {
+							if (meshData.HasTangents && material.normalTexture) {
 								textureInfo = &material.normalTexture.value();
+								mipChain.IsNormalMap = true;
 							}
 						}
 						break;
 					}
 
 					if (textureInfo != nullptr
-						&& textureInfo->texCoordIndex < 2 && hasTextureCoordinates[textureInfo->texCoordIndex]) {
-						auto& [Texture, TextureCoordinateIndex] = textures[i];
-						LoadTexture(
-							directoryPath, asset, *textureInfo,
-							forceSRGB, Texture, loadedTextures,
-							commandList
+						&& textureInfo->texCoordIndex < 2 && meshData.HasTextureCoordinates[textureInfo->texCoordIndex]) {
+						auto& [ImageIndex, TextureCoordinateIndex] = textures[i];
+						ImageIndex = AddTexture(
+							parsedAsset, *textureInfo, i,
+							forceSRGB, compressTextures, mipChain, modelData, textureSources
 						);
-						TextureCoordinateIndex = textureInfo->texCoordIndex;
+						TextureCoordinateIndex = static_cast<uint32_t>(textureInfo->texCoordIndex);
 					}
 				}
 			}
 		}
-
-		return mesh;
 	}
 }
 
 export namespace GLTFHelpers {
-	void LoadModel(
-		Model& model,
-		const path& filePath,
-		CommandList& commandList,
-		bool flipWindingOrder = false
-	) {
-		if (empty(filePath)) {
-			throw invalid_argument("Model file path cannot be empty");
+	// Decoded images shared by every model of a scene, keyed by ImageData::Key
+	class ImageCache {
+	public:
+		explicit ImageCache(const TextureCompressionDesc& textureCompression = {}) : m_textureCompression(textureCompression) {}
+
+		// Applies to the models decoded with this cache
+		const TextureCompressionDesc& GetTextureCompression() const noexcept { return m_textureCompression; }
+
+		template <typename Decoder>
+		shared_ptr<ScratchImage> Load(const TextureKey& key, Decoder&& decoder) {
+			promise<shared_ptr<ScratchImage>> promise;
+			shared_future<shared_ptr<ScratchImage>> future;
+			bool isOwner;
+			{
+				const scoped_lock lock(m_mutex);
+
+				auto& image = m_images[key];
+				isOwner = !image.valid();
+				if (isOwner) {
+					image = promise.get_future().share();
+				}
+				future = image;
+			}
+
+			if (isOwner) {
+				try {
+					promise.set_value(decoder());
+				}
+				catch (...) {
+					promise.set_exception(current_exception());
+				}
+			}
+
+			return future.get();
 		}
 
-		auto asset = ::Load(
-			filePath,
-			fastgltf::Category::OnlyRenderable | fastgltf::Category::Skins,
-			fastgltf::Options::GenerateMeshIndices,
-			fastgltf::Extensions::MSFT_texture_dds
-			| fastgltf::Extensions::KHR_materials_emissive_strength
-			| fastgltf::Extensions::KHR_materials_ior
-			| fastgltf::Extensions::KHR_materials_transmission
-		);
+		void Clear() {
+			const scoped_lock lock(m_mutex);
+
+			m_images.clear();
+		}
+
+	private:
+		TextureCompressionDesc m_textureCompression;
+
+		mutex m_mutex;
+		unordered_map<TextureKey, shared_future<shared_ptr<ScratchImage>>, TextureKey::Hasher> m_images;
+	};
+
+	class AssetCache {
+	public:
+		shared_ptr<const ParsedAsset> Load(const path& filePath) {
+			if (empty(filePath)) {
+				throw invalid_argument("Asset file path cannot be empty");
+			}
+
+			const auto canonicalPath = GetCanonicalPath(filePath);
+
+			promise<shared_ptr<const ParsedAsset>> promise;
+			shared_future<shared_ptr<const ParsedAsset>> future;
+			bool isOwner;
+			{
+				const scoped_lock lock(m_mutex);
+
+				auto& asset = m_assets[canonicalPath];
+				isOwner = !asset.valid();
+				if (isOwner) {
+					asset = promise.get_future().share();
+				}
+				future = asset;
+			}
+
+			if (isOwner) {
+				try {
+					promise.set_value(make_shared<const ParsedAsset>(
+						filePath,
+						g_modelCategory | g_animationCategory,
+						g_modelOptions | g_animationOptions,
+						g_modelExtensions
+					));
+				}
+				catch (...) {
+					promise.set_exception(current_exception());
+				}
+			}
+
+			return future.get();
+		}
+
+		void Clear() {
+			const scoped_lock lock(m_mutex);
+
+			m_assets.clear();
+		}
+
+	private:
+		mutex m_mutex;
+		unordered_map<path, shared_future<shared_ptr<const ParsedAsset>>> m_assets;
+	};
+
+	void DecodeModel(
+		ModelData& modelData,
+		const ParsedAsset& parsedAsset,
+		bool flipWindingOrder = false,
+		ImageCache* imageCache = nullptr,
+		const MeshOptimizationDesc& meshOptimization = {}
+	) {
+		const auto& asset = parsedAsset.Asset;
 
 		const auto sceneIndex = GetDefaultSceneIndex(asset);
 		const auto& scene = asset.scenes.at(sceneIndex);
 
-		model.Name = scene.name;
+		modelData.Name = scene.name;
+
+		// The node hierarchy is walked serially to lay out mesh nodes and skins, then primitives are decoded in parallel
+		struct PrimitiveInfo {
+			size_t MeshNodeIndex;
+			const fastgltf::Primitive* Primitive;
+		};
+		vector<PrimitiveInfo> primitives;
 
-		const auto directoryPath = filePath.parent_path();
-		vector<StoredSkinJoints> storedSkinJoints;
-		vector<LoadedTexture> loadedTextures;
+		vector<StoredSkin> storedSkins;
 		iterateSceneNodes(
 			asset, sceneIndex, fastgltf::math::fmat4x4(),
 			[&](fastgltf::Node& node, const fastgltf::math::fmat4x4& matrix) {
 				if (node.meshIndex) {
 					if (const auto& mesh = asset.meshes.at(node.meshIndex.value()); !empty(mesh.primitives)) {
-						auto meshNode = make_shared<MeshNode>();
+						auto& meshNodeData = modelData.MeshNodes.emplace_back();
 
-						meshNode->NodeName = node.name;
-						meshNode->MeshName = mesh.name;
+						meshNodeData.NodeName = node.name;
+						meshNodeData.MeshName = mesh.name;
 
-						meshNode->GlobalTransform = reinterpret_cast<const Matrix&>(matrix);
+						meshNodeData.GlobalTransform = reinterpret_cast<const Matrix&>(matrix);
 
 						if (node.skinIndex) {
-							size_t skinJointCount = 0;
-							if (const auto pStoredSkinJoints = ranges::find_if(storedSkinJoints, [&](const auto& value) {
+							if (const auto pStoredSkin = ranges::find_if(storedSkins, [&](const auto& value) {
 								return value.Index == node.skinIndex.value();
 								});
-								pStoredSkinJoints == cend(storedSkinJoints)) {
+								pStoredSkin == cend(storedSkins)) {
 								const auto& skin = asset.skins.at(node.skinIndex.value());
 								if (skin.inverseBindMatrices) {
-									auto skinJoints = make_shared<vector<SkinJoint>>();
-									skinJoints->reserve(size(skin.joints));
+									auto& skinJoints = modelData.Skins.emplace_back();
+									skinJoints.reserve(size(skin.joints));
 									fastgltf::iterateAccessor<fastgltf::math::fmat4x4>(
 										asset, asset.accessors.at(skin.inverseBindMatrices.value()),
 										[&](const fastgltf::math::fmat4x4& value) {
-											skinJoints->emplace_back(
-												string(asset.nodes.at(skin.joints.at(size(*skinJoints))).name),
+											skinJoints.emplace_back(
+												string(asset.nodes.at(skin.joints.at(size(skinJoints))).name),
 												reinterpret_cast<const Matrix&>(value)
 											);
-										}
+										},
+										parsedAsset
 									);
 
-									skinJointCount = size(*skinJoints);
+									meshNodeData.SkinIndex = static_cast<uint32_t>(size(modelData.Skins) - 1);
 
-									if (!model.SkinJoints) {
-										model.SkinJoints = make_shared<SkinJointDictionary>();
-									}
-
-									(*model.SkinJoints)[string(node.name)] = skinJoints;
-
-									storedSkinJoints.emplace_back(node.skinIndex.value(), skinJoints);
+									storedSkins.emplace_back(node.skinIndex.value(), meshNodeData.SkinIndex);
 								}
 							}
 							else {
-								skinJointCount = size(*pStoredSkinJoints->SkinJoints);
-
-								(*model.SkinJoints)[string(node.name)] = pStoredSkinJoints->SkinJoints;
-							}
-
-							if (skinJointCount) {
-								meshNode->SkeletalTransforms = GPUBuffer::CreateDefault<XMFLOAT3X4>(commandList.GetDeviceContext(), skinJointCount);
+								meshNodeData.SkinIndex = pStoredSkin->SkinIndex;
 							}
 						}
 
 						for (const auto& primitive : mesh.primitives) {
-							if (const auto _primitive = ProcessPrimitive(
-								directoryPath,
-								asset, primitive,
-								flipWindingOrder,
-								model,
-								loadedTextures,
-								commandList
-							)) {
-								meshNode->Meshes.emplace_back(_primitive);
-							}
+							primitives.emplace_back(size(modelData.MeshNodes) - 1, &primitive);
 						}
-
-						model.MeshNodes.emplace_back(meshNode);
 					}
 				}
 			}
 		);
+
+		// Each primitive becomes as many meshes as OptimizeMesh splits it into, none if it cannot be decoded
+		vector<vector<MeshData>> meshes(size(primitives));
+		ParallelFor(size(primitives), [&](size_t index) {
+			if (MeshData meshData; DecodePrimitive(parsedAsset, *primitives[index].Primitive, flipWindingOrder, meshData)) {
+				meshes[index] = OptimizeMesh(move(meshData), meshOptimization);
+			}
+		});
+
+		// Materials and texture references are assigned in glTF order, so that the result does not depend on scheduling
+		const auto compressTextures = imageCache != nullptr && imageCache->GetTextureCompression().IsEnabled;
+		vector<TextureSource> textureSources;
+		for (size_t i = 0; const auto & [MeshNodeIndex, Primitive] : primitives) {
+			if (auto& primitiveMeshes = meshes[i]; !empty(primitiveMeshes)) {
+				auto& firstMesh = primitiveMeshes.front();
+				DecodeMaterial(parsedAsset, *Primitive, firstMesh, modelData, textureSources, compressTextures);
+				const auto materialIndex = firstMesh.MaterialIndex, textureIndex = firstMesh.TextureIndex;
+				for (auto& meshData : primitiveMeshes) {
+					meshData.MaterialIndex = materialIndex;
+					meshData.TextureIndex = textureIndex;
+					modelData.MeshNodes[MeshNodeIndex].Meshes.emplace_back(move(meshData));
+				}
+			}
+			i++;
+		}
+
+		// Image files of the model are all queued for reading up front, then each is hashed and decoded from memory once read.
+		// Reads complete on threads of the reader rather than of the pool, so blocking on them below cannot starve them.
+		// DirectXTex decodes EXR from files only
+		vector<future<vector<std::byte>>> fileReads(size(textureSources));
+		for (size_t i = 0; const auto & textureSource : textureSources) {
+			if (const auto& filePath = textureSource.FilePath; !empty(filePath) && _wcsicmp(filePath.extension().c_str(), L".exr")) {
+				fileReads[i] = AsyncFileReader::GetDefault().Read(filePath);
+			}
+			i++;
+		}
+
+		ParallelFor(size(textureSources), [&](size_t index) {
+			auto textureSource = textureSources[index];
+			vector<std::byte> fileData;
+			if (auto& fileRead = fileReads[index]; fileRead.valid()) {
+				fileData = fileRead.get();
+				textureSource.Data = fileData;
+			}
+			auto& imageData = modelData.Images[textureSource.ImageIndex];
+			imageData.Key = GetKey(textureSource);
+			imageData.Image = imageCache != nullptr ?
+				imageCache->Load(imageData.Key, [&] {
+					return DecodeTexture(textureSource, imageData.Key, imageCache->GetTextureCompression().CacheDirectoryPath);
+				}) :
+				DecodeTexture(textureSource);
+		});
 	}
 
-	void LoadAnimation(AnimationCollection& animations, const path& filePath) {
+	void DecodeModel(
+		ModelData& modelData,
+		const path& filePath,
+		bool flipWindingOrder = false,
+		const MeshOptimizationDesc& meshOptimization = {}
+	) {
 		if (empty(filePath)) {
-			throw invalid_argument("Animation file path cannot be empty");
+			throw invalid_argument("Model file path cannot be empty");
 		}
 
-		auto asset = ::Load(
-			filePath,
-			fastgltf::Category::OnlyAnimations | fastgltf::Category::Nodes | fastgltf::Category::Scenes,
-			fastgltf::Options::DecomposeNodeMatrices
-		);
+		DecodeModel(modelData, ParsedAsset(filePath, g_modelCategory, g_modelOptions, g_modelExtensions), flipWindingOrder, nullptr, meshOptimization);
+	}
+
+	unique_ptr<ParsedAsset> ParseModel(const path& filePath, bool isMemoryMapped = true) {
+		return make_unique<ParsedAsset>(filePath, g_modelCategory, g_modelOptions, g_modelExtensions, isMemoryMapped);
+	}
+
+	void LoadModel(
+		Model& model,
+		const ParsedAsset& parsedAsset,
+		CommandList& commandList,
+		bool flipWindingOrder = false,
+		ImageCache* imageCache = nullptr, TextureCache* textureCache = nullptr,
+		const MeshOptimizationDesc& meshOptimization = {}
+	) {
+		ModelData modelData;
+		DecodeModel(modelData, parsedAsset, flipWindingOrder, imageCache, meshOptimization);
+		CreateModel(model, modelData, commandList, textureCache);
+	}
+
+	void LoadModel(
+		Model& model,
+		const path& filePath,
+		CommandList& commandList,
+		bool flipWindingOrder = false
+	) {
+		ModelData modelData;
+		DecodeModel(modelData, filePath, flipWindingOrder);
+		CreateModel(model, modelData, commandList);
+	}
+
+	void LoadAnimation(AnimationCollection& animations, const ParsedAsset& parsedAsset) {
+		const auto& asset = parsedAsset.Asset;
 
 		const auto sceneIndex = GetDefaultSceneIndex(asset);
 		const auto& scene = asset.scenes.at(sceneIndex);
@@ -598,13 +958,15 @@ export namespace GLTFHelpers {
 								[&](float value) {
 									keys.emplace_back(value);
 							duration = max(duration, value);
-								}
+								},
+								parsedAsset
 							);
 							fastgltf::iterateAccessorWithIndex<XMFLOAT3>(
 								asset, outputAccessor,
 								[&](const XMFLOAT3& value, size_t index) {
 									keys[index].Value = value;
-								}
+								},
+								parsedAsset
 							);
 							keyframeCollection.Translations.append_range(move(keys));
 						}
@@ -621,13 +983,15 @@ export namespace GLTFHelpers {
 								[&](float value) {
 									keys.emplace_back(value);
 							duration = max(duration, value);
-								}
+								},
+								parsedAsset
 							);
 							fastgltf::iterateAccessorWithIndex<XMFLOAT4>(
 								asset, outputAccessor,
 								[&](const XMFLOAT4& value, size_t index) {
 									keys[index].Value = value;
-								}
+								},
+								parsedAsset
 							);
 							keyframeCollection.Rotations.append_range(move(keys));
 						}
@@ -644,13 +1008,15 @@ export namespace GLTFHelpers {
 								[&](float value) {
 									keys.emplace_back(value);
 							duration = max(duration, value);
-								}
+								},
+								parsedAsset
 							);
 							fastgltf::iterateAccessorWithIndex<XMFLOAT3>(
 								asset, outputAccessor,
 								[&](const XMFLOAT3& value, size_t index) {
 									keys[index].Value = value;
-								}
+								},
+								parsedAsset
 							);
 							keyframeCollection.Scales.append_range(move(keys));
 						}
@@ -661,4 +1027,12 @@ export namespace GLTFHelpers {
 			animations.emplace_back(duration, move(keyframeCollections), targetNodes).Name = animation.name;
 		}
 	}
-}
+
+	void LoadAnimation(AnimationCollection& animations, const path& filePath) {
+		if (empty(filePath)) {
+			throw invalid_argument("Animation file path cannot be empty");
+		}
+
+		LoadAnimation(animations, ParsedAsset(filePath, g_animationCategory, g_animationOptions));
+	}
+}
\ No newline at end of file
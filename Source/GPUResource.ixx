@@ -35,6 +35,9 @@ export namespace DirectX {
 
 		bool IsOwner() const noexcept { return m_allocation; }
 
+		// Bytes of video memory owned by the resource, 0 if it wraps an external resource
+		size_t GetAllocationSize() const noexcept { return m_allocation ? m_allocation->GetSize() : 0; }
+
 		D3D12_RESOURCE_STATES GetInitialState() const noexcept { return m_initialState; }
 		bool KeepInitialState() const noexcept { return m_keepInitialState; }
 
@@ -0,0 +1,139 @@
+module;
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+#include "directx/d3d12.h"
+
+#include "DirectXTex.h"
+
+#include "spng.h"
+
+#include "turbojpeg.h"
+
+export module ImageDecoders;
+
+import ErrorHelpers;
+
+using namespace DirectX;
+using namespace ErrorHelpers;
+using namespace std;
+
+namespace {
+	constexpr unsigned char PNGSignature[]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' }, JPEGSignature[]{ 0xFF, 0xD8, 0xFF };
+
+	bool HasSignature(span<const std::byte> data, span<const unsigned char> signature) {
+		return size(data) >= size(signature) && !memcmp(::data(data), ::data(signature), size(signature));
+	}
+
+	void DecodePNG(ScratchImage& image, span<const std::byte> data, bool forceSRGB) {
+		const unique_ptr<spng_ctx, decltype(&spng_ctx_free)> context(spng_ctx_new(0), spng_ctx_free);
+		if (!context) {
+			throw bad_alloc();
+		}
+
+		const auto ThrowIfError = [](int error) {
+			if (error) {
+				Throw<runtime_error>(format("Failed to decode PNG image: {}", spng_strerror(error)));
+			}
+		};
+
+		ThrowIfError(spng_set_png_buffer(context.get(), ::data(data), size(data)));
+
+		spng_ihdr header;
+		ThrowIfError(spng_get_ihdr(context.get(), &header));
+
+		// Same formats as WIC: 8-bit grayscale without transparency stays single-channel, deeper images keep 16 bits
+		spng_trns transparency;
+		int outputFormat;
+		DXGI_FORMAT format;
+		if (header.color_type == SPNG_COLOR_TYPE_GRAYSCALE && header.bit_depth <= 8 && spng_get_trns(context.get(), &transparency)) {
+			outputFormat = SPNG_FMT_G8;
+			format = DXGI_FORMAT_R8_UNORM;
+		}
+		else if (header.bit_depth == 16) {
+			outputFormat = SPNG_FMT_RGBA16;
+			format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		}
+		else {
+			outputFormat = SPNG_FMT_RGBA8;
+
+			// Like DirectXTex, an sRGB chunk or a gamma of 1/2.2 marks the image as sRGB
+			uint8_t renderingIntent;
+			double gamma;
+			format = forceSRGB
+				|| !spng_get_srgb(context.get(), &renderingIntent)
+				|| (!spng_get_gama(context.get(), &gamma) && abs(gamma - 0.45455) < 1e-5) ?
+				DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+
+		size_t imageSize;
+		ThrowIfError(spng_decoded_image_size(context.get(), outputFormat, &imageSize));
+
+		ThrowIfFailed(image.Initialize2D(format, header.width, header.height, 1, 1));
+		if (imageSize != image.GetPixelsSize()) {
+			Throw<runtime_error>("Failed to decode PNG image: Unexpected image size");
+		}
+		ThrowIfError(spng_decode_image(context.get(), image.GetPixels(), imageSize, outputFormat, SPNG_DECODE_TRNS));
+	}
+
+	// Returns false for CMYK images, which cannot be converted to RGB
+	bool DecodeJPEG(ScratchImage& image, span<const std::byte> data, bool forceSRGB) {
+		const unique_ptr<void, decltype(&tj3Destroy)> handle(tj3Init(TJINIT_DECOMPRESS), tj3Destroy);
+		if (!handle) {
+			throw bad_alloc();
+		}
+
+		const auto ThrowIfError = [&](int error) {
+			if (error) {
+				Throw<runtime_error>(format("Failed to decode JPEG image: {}", tj3GetErrorStr(handle.get())));
+			}
+		};
+
+		const auto _data = reinterpret_cast<const unsigned char*>(::data(data));
+		ThrowIfError(tj3DecompressHeader(handle.get(), _data, size(data)));
+
+		const auto colorspace = tj3Get(handle.get(), TJPARAM_COLORSPACE);
+		if (colorspace == TJCS_CMYK || colorspace == TJCS_YCCK) {
+			return false;
+		}
+
+		const auto isGrayscale = colorspace == TJCS_GRAY;
+		ThrowIfFailed(image.Initialize2D(
+			isGrayscale ? DXGI_FORMAT_R8_UNORM : forceSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM,
+			tj3Get(handle.get(), TJPARAM_JPEGWIDTH), tj3Get(handle.get(), TJPARAM_JPEGHEIGHT), 1, 1
+		));
+
+		const auto& output = *image.GetImage(0, 0, 0);
+		ThrowIfError(tj3Decompress8(
+			handle.get(), _data, size(data),
+			output.pixels, static_cast<int>(output.rowPitch), isGrayscale ? TJPF_GRAY : TJPF_RGBA
+		));
+
+		return true;
+	}
+}
+
+export namespace DirectX::TextureHelpers {
+	enum class ImageDecoder {
+		WIC,
+
+		// libspng and libjpeg-turbo, whose SIMD paths decode PNG and JPEG images faster than WIC; other images still go through WIC
+		Portable
+	};
+
+	/*
+	 * Decodes PNG and JPEG images into a single 8-bit or 16-bit UNORM level, in the formats WIC would pick.
+	 * Returns false, leaving image untouched, for images of other formats or that these decoders cannot convert to RGB.
+	 */
+	bool DecodePortableImage(ScratchImage& image, span<const std::byte> data, bool forceSRGB = false) {
+		if (HasSignature(data, PNGSignature)) {
+			DecodePNG(image, data, forceSRGB);
+			return true;
+		}
+		return HasSignature(data, JPEGSignature) && DecodeJPEG(image, data, forceSRGB);
+	}
+}
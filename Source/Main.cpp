@@ -1,3 +1,4 @@
+#include <iostream>
 #include <set>
 
 #include <Windows.h>
@@ -18,6 +19,7 @@
 
 import App;
 import ErrorHelpers;
+import ScenePackCooker;
 import SharedData;
 
 using namespace DirectX;
@@ -60,6 +62,18 @@ int WINAPI wWinMain(
 	try {
 		ThrowIfFailed(RoInitialize(RO_INIT_MULTITHREADED));
 
+		// PhysicallyBasedRaytracer --cook-scene-pack <Scene.json> <Scene.scenepack>
+		if (__argc == 4 && !_wcsicmp(__wargv[1], L"--cook-scene-pack")) {
+			if (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole()) {
+				FILE* file;
+				ignore = freopen_s(&file, "CONOUT$", "w", stdout);
+			}
+
+			CookScenePack(__wargv[2], __wargv[3], cout);
+
+			return ERROR_SUCCESS;
+		}
+
 		ignore = NvAPI_Initialize();
 
 		LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
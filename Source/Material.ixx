@@ -33,7 +33,8 @@ export {
 	};
 
 	struct TextureMapInfo {
-		uint32_t Descriptor = ~0u, TextureCoordinateIndex{};
-		XMUINT2 _;
+		// Material textures are viewed as 2D arrays, small ones being packed together
+		uint32_t Descriptor = ~0u, TextureCoordinateIndex{}, ArraySlice{};
+		uint32_t _;
 	};
 }
@@ -0,0 +1,102 @@
+module;
+
+#include <algorithm>
+#include <cwchar>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <tuple>
+
+#include <Windows.h>
+
+#include <wrl.h>
+
+export module MemoryMappedFile;
+
+import ErrorHelpers;
+
+using namespace ErrorHelpers;
+using namespace Microsoft::WRL::Wrappers;
+using namespace std;
+using namespace std::filesystem;
+
+export class MemoryMappedFile {
+public:
+	MemoryMappedFile(const MemoryMappedFile&) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+	explicit MemoryMappedFile(const path& filePath) noexcept(false) {
+		const auto filePathString = filePath.string();
+
+		FileHandle file(CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+		ThrowIfFailed(static_cast<BOOL>(file.IsValid()), filePathString);
+
+		LARGE_INTEGER size;
+		ThrowIfFailed(GetFileSizeEx(file.Get(), &size), filePathString);
+		m_size = static_cast<size_t>(size.QuadPart);
+		if (!m_size) {
+			return;
+		}
+
+		const HandleT<HandleTraits::HANDLENullTraits> mapping(CreateFileMappingW(file.Get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+		ThrowIfFailed(static_cast<BOOL>(mapping.IsValid()), filePathString);
+
+		m_view.reset(static_cast<const std::byte*>(MapViewOfFile(mapping.Get(), FILE_MAP_READ, 0, 0, 0)));
+		ThrowIfFailed(static_cast<BOOL>(m_view != nullptr), filePathString);
+	}
+
+	/*
+	 * Maps a temporary file holding chunks one after another, which is deleted once unmapped.
+	 * Unlike a copy in memory, its pages can be dropped by the system and read back when accessed again.
+	 */
+	explicit MemoryMappedFile(span<const span<const std::byte>> chunks) noexcept(false) {
+		wstring filePath(MAX_PATH, 0);
+		ThrowIfFailed(static_cast<BOOL>(GetTempFileNameW(temp_directory_path().c_str(), L"MMF", 0, data(filePath)) != 0));
+		filePath.resize(wcslen(filePath.c_str()));
+		const auto filePathString = path(filePath).string();
+
+		FileHandle file(CreateFileW(
+			filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr
+		));
+		ThrowIfFailed(static_cast<BOOL>(file.IsValid()), filePathString);
+
+		for (const auto& chunk : chunks) {
+			for (size_t offset = 0; offset < size(chunk);) {
+				DWORD writtenSize;
+				ThrowIfFailed(WriteFile(file.Get(), ::data(chunk) + offset, static_cast<DWORD>(min<size_t>(size(chunk) - offset, 1 << 30)), &writtenSize, nullptr), filePathString);
+				offset += writtenSize;
+			}
+			m_size += size(chunk);
+		}
+		if (!m_size) {
+			return;
+		}
+
+		// The view keeps the file alive after its handle is closed
+		const HandleT<HandleTraits::HANDLENullTraits> mapping(CreateFileMappingW(file.Get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+		ThrowIfFailed(static_cast<BOOL>(mapping.IsValid()), filePathString);
+
+		m_view.reset(static_cast<const std::byte*>(MapViewOfFile(mapping.Get(), FILE_MAP_READ, 0, 0, 0)));
+		ThrowIfFailed(static_cast<BOOL>(m_view != nullptr), filePathString);
+	}
+
+	span<const std::byte> GetData() const noexcept { return { m_view.get(), m_size }; }
+
+	// Asks for the whole view to be read in with large concurrent I/O rather than faulted in page by page; a hint that may be ignored
+	void Prefetch() const noexcept {
+		if (m_size) {
+			WIN32_MEMORY_RANGE_ENTRY range{ const_cast<std::byte*>(m_view.get()), m_size };
+			ignore = PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+	}
+
+	size_t GetSize() const noexcept { return m_size; }
+
+private:
+	struct ViewDeleter { void operator()(const std::byte* p) const noexcept { UnmapViewOfFile(p); } };
+	unique_ptr<const std::byte, ViewDeleter> m_view;
+
+	size_t m_size{};
+};
@@ -0,0 +1,402 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <DirectXPackedVector.h>
+
+#include "directx/d3d12.h"
+
+#include "meshoptimizer.h"
+
+export module MeshOptimization;
+
+import Model;
+import ModelData;
+
+using namespace DirectX::PackedVector;
+using namespace std;
+
+namespace {
+	vector<uint32_t> GetIndices(const MeshData& meshData) {
+		const auto ToVector = [&]<typename T> {
+			const span indices(reinterpret_cast<const T*>(data(meshData.Indices)), meshData.GetIndexCount());
+			return vector<uint32_t>(cbegin(indices), cend(indices));
+		};
+		return meshData.IndexFormat == DXGI_FORMAT_R16_UINT ? ToVector.operator() < uint16_t > () : ToVector.operator() < uint32_t > ();
+	}
+
+	vector<uint8_t> EncodeIndices(span<const uint32_t> indices, DXGI_FORMAT format) {
+		vector<uint8_t> data;
+		const auto Encode = [&]<typename T> {
+			data.resize(size(indices) * sizeof(T));
+			ranges::transform(indices, reinterpret_cast<T*>(::data(data)), [](uint32_t index) { return static_cast<T>(index); });
+		};
+		if (format == DXGI_FORMAT_R16_UINT) {
+			Encode.operator() < uint16_t > ();
+		}
+		else {
+			Encode.operator() < uint32_t > ();
+		}
+		return data;
+	}
+
+	void SetIndices(MeshData& meshData, span<const uint32_t> indices) {
+		meshData.IndexFormat = size(meshData.Vertices) <= UINT16_MAX ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		meshData.Indices = EncodeIndices(indices, meshData.IndexFormat);
+	}
+
+	/*
+	 * Keeps at most maxInfluenceCount influences per vertex, dropping the ones weighing less than minWeight,
+	 * and stores them by decreasing weight, normalized to sum to one, with dropped joints zeroed so that vertices weld more often.
+	 */
+	void ReduceSkinInfluences(MeshData& meshData, size_t maxInfluenceCount, float minWeight) {
+		for (auto& vertex : meshData.SkeletalVertices) {
+			const auto joints = reinterpret_cast<uint16_t*>(&vertex.Joints);
+			const auto weights = reinterpret_cast<float*>(&vertex.Weights);
+
+			array<pair<float, uint16_t>, 4> influences;
+			float sum = 0;
+			for (size_t i = 0; i < size(influences); i++) {
+				influences[i] = { max(weights[i], 0.0f), joints[i] };
+				sum += influences[i].first;
+			}
+			ranges::sort(influences, greater());
+
+			size_t influenceCount = 0;
+			float keptSum = 0;
+			for (const auto& [weight, _] : influences) {
+				if (influenceCount == maxInfluenceCount || (influenceCount && (weight <= 0 || weight < minWeight * sum))) {
+					break;
+				}
+				keptSum += weight;
+				influenceCount++;
+			}
+
+			for (size_t i = 0; i < size(influences); i++) {
+				if (i < influenceCount) {
+					weights[i] = keptSum > 0 ? influences[i].first / keptSum : 1;
+					joints[i] = influences[i].second;
+				}
+				else {
+					weights[i] = 0;
+					joints[i] = 0;
+				}
+			}
+		}
+	}
+
+	// Merges vertices whose attributes, skinning included, are bit-identical, dropping the ones no triangle references
+	void WeldVertices(MeshData& meshData, vector<uint32_t>& indices) {
+		const auto vertexCount = size(meshData.Vertices);
+
+		vector<meshopt_Stream> streams{ { data(meshData.Vertices), sizeof(Mesh::VertexType), sizeof(Mesh::VertexType) } };
+		if (!empty(meshData.SkeletalVertices)) {
+			streams.emplace_back(data(meshData.SkeletalVertices), sizeof(Mesh::SkeletalVertexType), sizeof(Mesh::SkeletalVertexType));
+		}
+
+		vector<uint32_t> remap(vertexCount);
+		const auto uniqueVertexCount = meshopt_generateVertexRemapMulti(data(remap), data(indices), size(indices), vertexCount, data(streams), size(streams));
+
+		meshopt_remapIndexBuffer(data(indices), data(indices), size(indices), data(remap));
+
+		const auto RemapVertices = [&]<typename T>(vector<T>&vertices) {
+			if (!empty(vertices)) {
+				vector<T> remappedVertices(uniqueVertexCount);
+				meshopt_remapVertexBuffer(data(remappedVertices), data(vertices), vertexCount, sizeof(T), data(remap));
+				vertices = move(remappedVertices);
+			}
+		};
+		RemapVertices(meshData.Vertices);
+		RemapVertices(meshData.SkeletalVertices);
+	}
+
+	// Keeps the first of triangles that have the same vertices in the same winding order
+	void RemoveDegenerateAndDuplicateTriangles(vector<uint32_t>& indices) {
+		using Triangle = array<uint32_t, 3>;
+		vector<pair<Triangle, uint32_t>> triangles;
+		triangles.reserve(size(indices) / 3);
+		for (uint32_t i = 0; i + 2 < size(indices); i += 3) {
+			Triangle triangle{ indices[i], indices[i + 1], indices[i + 2] };
+			if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]) {
+				continue;
+			}
+			ranges::rotate(triangle, ranges::min_element(triangle));
+			triangles.emplace_back(triangle, i);
+		}
+		ranges::sort(triangles);
+		const auto [first, last] = ranges::unique(triangles, {}, &pair<Triangle, uint32_t>::first);
+		triangles.erase(first, last);
+		ranges::sort(triangles, {}, &pair<Triangle, uint32_t>::second);
+
+		vector<uint32_t> uniqueIndices;
+		uniqueIndices.reserve(size(triangles) * 3);
+		for (const auto& [_, index] : triangles) {
+			uniqueIndices.insert(cend(uniqueIndices), cbegin(indices) + index, cbegin(indices) + index + 3);
+		}
+		indices = move(uniqueIndices);
+	}
+
+	// Drops vertices that only removed triangles referenced, keeping the order of the others
+	void RemoveUnusedVertices(MeshData& meshData, vector<uint32_t>& indices) {
+		vector<uint32_t> newIndices(size(meshData.Vertices), ~0u);
+		for (const auto index : indices) {
+			newIndices[index] = 0;
+		}
+		uint32_t vertexCount = 0;
+		for (uint32_t i = 0; auto & newIndex : newIndices) {
+			if (newIndex != ~0u) {
+				newIndex = vertexCount;
+				meshData.Vertices[vertexCount] = meshData.Vertices[i];
+				if (!empty(meshData.SkeletalVertices)) {
+					meshData.SkeletalVertices[vertexCount] = meshData.SkeletalVertices[i];
+				}
+				vertexCount++;
+			}
+			i++;
+		}
+		meshData.Vertices.resize(vertexCount);
+		if (!empty(meshData.SkeletalVertices)) {
+			meshData.SkeletalVertices.resize(vertexCount);
+		}
+		for (auto& index : indices) {
+			index = newIndices[index];
+		}
+	}
+
+	// Renumbers vertices in the order triangles first use them, dropping unreferenced ones
+	void ReorderVertices(MeshData& meshData, vector<uint32_t>& indices) {
+		const auto vertexCount = size(meshData.Vertices);
+
+		vector<uint32_t> remap(vertexCount);
+		const auto usedVertexCount = meshopt_optimizeVertexFetchRemap(data(remap), data(indices), size(indices), vertexCount);
+
+		meshopt_remapIndexBuffer(data(indices), data(indices), size(indices), data(remap));
+
+		const auto RemapVertices = [&]<typename T>(vector<T>&vertices) {
+			if (!empty(vertices)) {
+				vector<T> remappedVertices(usedVertexCount);
+				meshopt_remapVertexBuffer(data(remappedVertices), data(vertices), vertexCount, sizeof(T), data(remap));
+				vertices = move(remappedVertices);
+			}
+		};
+		RemapVertices(meshData.Vertices);
+		RemapVertices(meshData.SkeletalVertices);
+	}
+
+	// Sorts triangles along the Morton curve of their centroids
+	void SortTriangles(const MeshData& meshData, vector<uint32_t>& indices) {
+		vector<uint32_t> sortedIndices(size(indices));
+		meshopt_spatialSortTriangles(
+			data(sortedIndices), data(indices), size(indices),
+			&meshData.Vertices[0].Position.x, size(meshData.Vertices), sizeof(Mesh::VertexType)
+		);
+		indices = move(sortedIndices);
+	}
+
+	/*
+	 * Walks triangles in order and starts a new mesh whenever the next triangle would take the current one past maxVertexCount vertices,
+	 * so that spatially sorted triangles give parts that each cover a compact region, with vertices in first-use order.
+	 */
+	vector<MeshData> SplitMesh(const MeshData& meshData, span<const uint32_t> sortedIndices, size_t maxVertexCount) {
+		const auto vertexCount = size(meshData.Vertices);
+
+		vector<MeshData> meshes;
+		// Indices of the source vertices in the current part, ~0u for the ones it does not have yet
+		vector<uint32_t> localIndices(vertexCount, ~0u), partIndices, partVertexIndices;
+		MeshData part;
+		const auto Flush = [&] {
+			if (empty(partIndices)) {
+				return;
+			}
+			SetIndices(part, partIndices);
+			meshes.emplace_back(move(part));
+			part = {};
+			partIndices.clear();
+			for (const auto index : partVertexIndices) {
+				localIndices[index] = ~0u;
+			}
+			partVertexIndices.clear();
+		};
+
+		for (size_t i = 0; i < size(sortedIndices); i += 3) {
+			const auto triangle = sortedIndices.subspan(i, 3);
+			const auto newVertexCount = static_cast<size_t>(ranges::count_if(triangle, [&](uint32_t index) { return localIndices[index] == ~0u; }));
+			if (size(part.Vertices) + newVertexCount > maxVertexCount) {
+				Flush();
+			}
+			for (const auto index : triangle) {
+				auto& localIndex = localIndices[index];
+				if (localIndex == ~0u) {
+					localIndex = static_cast<uint32_t>(size(part.Vertices));
+					partVertexIndices.emplace_back(index);
+					part.Vertices.emplace_back(meshData.Vertices[index]);
+					if (!empty(meshData.SkeletalVertices)) {
+						part.SkeletalVertices.emplace_back(meshData.SkeletalVertices[index]);
+					}
+				}
+				partIndices.emplace_back(localIndex);
+			}
+		}
+		Flush();
+
+		for (auto& mesh : meshes) {
+			mesh.HasNormals = meshData.HasNormals;
+			mesh.HasTangents = meshData.HasTangents;
+			ranges::copy(meshData.HasTextureCoordinates, mesh.HasTextureCoordinates);
+			mesh.MaterialIndex = meshData.MaterialIndex;
+			mesh.TextureIndex = meshData.TextureIndex;
+		}
+
+		return meshes;
+	}
+}
+
+export {
+	struct MeshLODDesc {
+		// Off unless LODs are selected at runtime or cooked into a scene pack, as nothing else reads them
+		bool IsEnabled{};
+
+		size_t MaxLevelCount = 4;
+
+		// Each level targets this fraction of the triangles of the previous one
+		float TriangleRatio = 0.5f;
+
+		// Relative to the extent of the mesh, accumulated over levels; levels are no longer generated past it
+		float MaxError = 0.05f;
+
+		// Weights of normal and texture coordinate deviations against relative positional error
+		float NormalWeight = 0.5f, TextureCoordinateWeight = 0.5f;
+	};
+
+	/*
+	 * Replaces the LODs of meshData with a chain simplified by quadric error with attribute weights, each level from the previous one.
+	 * Border vertices are locked, so that meshes split from the same primitive keep meeting.
+	 * Levels stop once simplification no longer removes a tenth of the triangles or would exceed desc.MaxError.
+	 * Skinned meshes get none, as their BLASes are rebuilt every frame at full detail.
+	 */
+	void GenerateLODs(MeshData& meshData, const MeshLODDesc& desc = {}) {
+		meshData.LODs.clear();
+		if (!desc.IsEnabled || !empty(meshData.SkeletalVertices) || empty(meshData.Vertices)) {
+			return;
+		}
+
+		const auto vertexCount = size(meshData.Vertices);
+		const auto positions = &meshData.Vertices[0].Position.x;
+
+		// Normal, then first texture coordinates, zero-weighted when absent
+		constexpr size_t AttributeCount = 5;
+		const auto normalWeight = meshData.HasNormals ? desc.NormalWeight : 0, textureCoordinateWeight = meshData.HasTextureCoordinates[0] ? desc.TextureCoordinateWeight : 0;
+		const float attributeWeights[AttributeCount]{ normalWeight, normalWeight, normalWeight, textureCoordinateWeight, textureCoordinateWeight };
+		vector<float> attributes(vertexCount * AttributeCount);
+		for (auto pAttributes = data(attributes); const auto & vertex : meshData.Vertices) {
+			const auto normal = reinterpret_cast<const int16_t*>(&vertex.Normal);
+			for (size_t i = 0; i < 3; i++) {
+				pAttributes[i] = max(static_cast<float>(normal[i]) / INT16_MAX, -1.0f);
+			}
+			pAttributes[3] = XMConvertHalfToFloat(vertex.TextureCoordinates[0].x);
+			pAttributes[4] = XMConvertHalfToFloat(vertex.TextureCoordinates[0].y);
+			pAttributes += AttributeCount;
+		}
+
+		const auto scale = meshopt_simplifyScale(positions, vertexCount, sizeof(Mesh::VertexType));
+
+		auto indices = GetIndices(meshData);
+		float error = 0;
+		while (size(meshData.LODs) < desc.MaxLevelCount) {
+			const auto targetIndexCount = static_cast<size_t>(static_cast<float>(size(indices) / 3) * desc.TriangleRatio) * 3;
+			if (targetIndexCount < 3) {
+				break;
+			}
+
+			vector<uint32_t> LODIndices(size(indices));
+			float levelError;
+			LODIndices.resize(meshopt_simplifyWithAttributes(
+				data(LODIndices), data(indices), size(indices),
+				positions, vertexCount, sizeof(Mesh::VertexType),
+				data(attributes), AttributeCount * sizeof(float), attributeWeights, AttributeCount, nullptr,
+				targetIndexCount, desc.MaxError - error, meshopt_SimplifyLockBorder, &levelError
+			));
+			if (empty(LODIndices) || size(LODIndices) * 10 > size(indices) * 9) {
+				break;
+			}
+
+			error += levelError;
+			indices = move(LODIndices);
+
+			auto sortedIndices = indices;
+			SortTriangles(meshData, sortedIndices);
+			meshData.LODs.emplace_back(EncodeIndices(sortedIndices, meshData.IndexFormat), error * scale);
+		}
+	}
+
+	struct MeshOptimizationDesc {
+		// Triangles are sorted spatially and vertices renumbered in first-use order, so that rays hitting nearby surfaces fetch nearby memory
+		bool IsReorderingEnabled = true;
+
+		size_t MaxVertexCount = UINT16_MAX;
+
+		// Skinned vertices keep their MaxSkinInfluenceCount largest influences weighing at least MinSkinWeight, which UNORM8 weights could not represent anyway
+		size_t MaxSkinInfluenceCount = 4;
+		float MinSkinWeight = 1.0f / 255;
+
+		MeshLODDesc LOD;
+	};
+
+	// LODs of meshData are dropped, as they index vertices in their previous order
+	void ReorderMesh(MeshData& meshData) {
+		meshData.LODs.clear();
+
+		auto indices = GetIndices(meshData);
+		if (empty(indices)) {
+			return;
+		}
+		SortTriangles(meshData, indices);
+		ReorderVertices(meshData, indices);
+		SetIndices(meshData, indices);
+	}
+
+	/*
+	 * Reduces skin influences, welds bit-identical vertices, removes degenerate and duplicate triangles, and splits meshes that are left with more vertices
+	 * than 16-bit indices can address into spatially coherent parts, so that every result uses the smallest index format.
+	 * Each result then gets its LODs. Empty if no triangle is left.
+	 */
+	vector<MeshData> OptimizeMesh(MeshData&& meshData, const MeshOptimizationDesc& desc = {}) {
+		ReduceSkinInfluences(meshData, desc.MaxSkinInfluenceCount, desc.MinSkinWeight);
+
+		auto indices = GetIndices(meshData);
+		WeldVertices(meshData, indices);
+		RemoveDegenerateAndDuplicateTriangles(indices);
+		if (empty(indices)) {
+			return {};
+		}
+
+		const auto shouldSplit = size(meshData.Vertices) > desc.MaxVertexCount;
+		if (desc.IsReorderingEnabled || shouldSplit) {
+			SortTriangles(meshData, indices);
+		}
+		vector<MeshData> meshes;
+		if (shouldSplit) {
+			meshes = SplitMesh(meshData, indices, desc.MaxVertexCount);
+		}
+		else {
+			if (desc.IsReorderingEnabled) {
+				ReorderVertices(meshData, indices);
+			}
+			else {
+				RemoveUnusedVertices(meshData, indices);
+			}
+			SetIndices(meshData, indices);
+			meshes.emplace_back(move(meshData));
+		}
+
+		for (auto& mesh : meshes) {
+			GenerateLODs(mesh, desc.LOD);
+		}
+
+		return meshes;
+	}
+}
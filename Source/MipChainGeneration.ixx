@@ -0,0 +1,125 @@
+module;
+
+#include <algorithm>
+#include <cstring>
+
+#include "directx/d3d12.h"
+
+#include "DirectXTex.h"
+
+export module MipChainGeneration;
+
+import ErrorHelpers;
+import ThreadHelpers;
+
+using namespace DirectX;
+using namespace ErrorHelpers;
+using namespace std;
+using namespace ThreadHelpers;
+
+namespace {
+	constexpr auto WorkingFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+	XMVECTOR* GetRow(const Image& image, size_t y) { return reinterpret_cast<XMVECTOR*>(image.pixels + y * image.rowPitch); }
+
+	void CopyImage(const Image& source, const Image& destination) {
+		const auto rowSize = min(source.rowPitch, destination.rowPitch);
+		for (size_t y = 0; y < source.height; y++) {
+			memcpy(destination.pixels + y * destination.rowPitch, source.pixels + y * source.rowPitch, rowSize);
+		}
+	}
+
+	// Converts between the image format and linear 32-bit floats, sRGB being decoded and encoded by DirectXTex on the way
+	void ConvertImage(const Image& source, DXGI_FORMAT format, ScratchImage& destination) {
+		if (source.format == format) {
+			ThrowIfFailed(destination.InitializeFromImage(source));
+		}
+		else {
+			ThrowIfFailed(Convert(source, format, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, destination));
+		}
+	}
+}
+
+export namespace DirectX::TextureHelpers {
+	struct MipChainDesc {
+		// Averaged normals are renormalized, so that minified normal maps keep unit-length normals
+		bool IsNormalMap{};
+
+		// For alpha-masked textures, mips are scaled to keep the fraction of texels passing the cutoff; 0 to disable
+		float AlphaCutoff{};
+
+		bool operator==(const MipChainDesc&) const = default;
+	};
+
+	/*
+	 * Generates the full mip chain of 2D textures that have a single level, with a 2x2 box filter applied in linear space.
+	 * Rows of each level are filtered in parallel, four channels at a time.
+	 * Block-compressed, typeless, planar and 3D textures are left as is.
+	 */
+	void GenerateMipChain(ScratchImage& image, const MipChainDesc& desc = {}) {
+		const auto& metadata = image.GetMetadata();
+		if (metadata.mipLevels != 1 || (metadata.width == 1 && metadata.height == 1)
+			|| metadata.dimension != TEX_DIMENSION_TEXTURE2D
+			|| IsCompressed(metadata.format) || IsTypeless(metadata.format) || IsPlanar(metadata.format) || IsPalettized(metadata.format)) {
+			return;
+		}
+
+		auto mipChainMetadata = metadata;
+		mipChainMetadata.mipLevels = 0;
+		ScratchImage mipChain;
+		ThrowIfFailed(mipChain.Initialize(mipChainMetadata));
+		const auto mipLevels = mipChain.GetMetadata().mipLevels;
+
+		for (size_t item = 0; item < metadata.arraySize; item++) {
+			const auto& sourceImage = *image.GetImage(0, item, 0);
+			CopyImage(sourceImage, *mipChain.GetImage(0, item, 0));
+
+			ScratchImage previousLevel;
+			ConvertImage(sourceImage, WorkingFormat, previousLevel);
+
+			for (size_t level = 1; level < mipLevels; level++) {
+				const auto& source = *previousLevel.GetImage(0, 0, 0);
+				const auto& destination = *mipChain.GetImage(level, item, 0);
+
+				ScratchImage currentLevel;
+				ThrowIfFailed(currentLevel.Initialize2D(WorkingFormat, destination.width, destination.height, 1, 1));
+				const auto& current = *currentLevel.GetImage(0, 0, 0);
+
+				ParallelFor(current.height, [&](size_t y) {
+					const auto sourceRow0 = GetRow(source, min(y * 2, source.height - 1)), sourceRow1 = GetRow(source, min(y * 2 + 1, source.height - 1));
+					const auto currentRow = GetRow(current, y);
+					for (size_t x = 0; x < current.width; x++) {
+						const auto x0 = min(x * 2, source.width - 1), x1 = min(x * 2 + 1, source.width - 1);
+						auto value = XMVectorScale(
+							XMVectorAdd(XMVectorAdd(sourceRow0[x0], sourceRow0[x1]), XMVectorAdd(sourceRow1[x0], sourceRow1[x1])),
+							0.25f
+						);
+						if (desc.IsNormalMap) {
+							const auto normal = XMVector3Normalize(XMVectorMultiplyAdd(value, g_XMTwo, g_XMNegativeOne));
+							value = XMVectorSelect(value, XMVectorMultiplyAdd(normal, g_XMOneHalf, g_XMOneHalf), g_XMSelect1110);
+						}
+						currentRow[x] = value;
+					}
+				});
+
+				ScratchImage convertedLevel;
+				ConvertImage(current, metadata.format, convertedLevel);
+				CopyImage(*convertedLevel.GetImage(0, 0, 0), destination);
+
+				previousLevel = move(currentLevel);
+			}
+
+			if (desc.AlphaCutoff > 0 && HasAlpha(metadata.format)) {
+				// Reads the box-filtered chain and writes every level past the first with its alpha scaled
+				ScratchImage scaledMipChain;
+				ThrowIfFailed(scaledMipChain.Initialize(mipChain.GetMetadata()));
+				ThrowIfFailed(ScaleMipMapsAlphaForCoverage(mipChain.GetImage(0, item, 0), mipLevels, mipChain.GetMetadata(), item, desc.AlphaCutoff, scaledMipChain));
+				for (size_t level = 1; level < mipLevels; level++) {
+					CopyImage(*scaledMipChain.GetImage(level, item, 0), *mipChain.GetImage(level, item, 0));
+				}
+			}
+		}
+
+		image = move(mipChain);
+	}
+}
@@ -33,7 +33,60 @@ export {
 
 		uint32_t MaterialIndex = ~0u, TextureIndex = ~0u;
 
+		struct LOD {
+			shared_ptr<GPUBuffer> Indices;
+
+			// Object space distance by which the simplified surface may deviate from the full one
+			float Error{};
+		};
+		// Simplified index buffers over the same vertices, from finest to coarsest
+		vector<LOD> LODs;
+
+		// Object space bounds of the vertices
+		BoundingSphere Bounds;
+
+		// Level 0 is the full mesh; levels past the last LOD use it
+		const shared_ptr<GPUBuffer>& GetIndices(size_t LODIndex) const {
+			return LODIndex && !empty(LODs) ? LODs[min(LODIndex, size(LODs)) - 1].Indices : Indices;
+		}
+
+		// See VertexDesc::IsCompact; PositionTransforms holds, at PositionTransformIndex, the 3x4 matrix of PositionScale and PositionOffset for BLAS builds
+		bool IsCompact{};
+		XMFLOAT3 PositionScale{ 1, 1, 1 }, PositionOffset{};
+		shared_ptr<GPUBuffer> PositionTransforms;
+		uint32_t PositionTransformIndex{};
+
+		static constexpr uint32_t CompactPositionSize = sizeof(XMSHORTN4), CompactTangentFrameSize = sizeof(uint32_t), CompactTextureCoordinateSize = sizeof(XMHALF2);
+
+		uint32_t GetCompactVertexStride() const {
+			return CompactPositionSize
+				+ (HasNormals ? CompactTangentFrameSize : 0)
+				+ static_cast<uint32_t>(ranges::count(HasTextureCoordinates, true)) * CompactTextureCoordinateSize;
+		}
+
+		// See SkinDesc
+		bool Has8BitJoints{}, Has8BitWeights{};
+
+		SkinDesc GetSkinDesc() const { return { Has8BitJoints, Has8BitWeights }; }
+
 		VertexDesc GetVertexDesc() const {
+			if (IsCompact) {
+				VertexDesc vertexDesc{ .Stride = CompactPositionSize, .PositionScale = PositionScale, .PositionOffset = PositionOffset, .IsCompact = true };
+				if (HasNormals) {
+					vertexDesc.AttributeOffsets.Normal = vertexDesc.Stride;
+					if (HasTangents) {
+						vertexDesc.AttributeOffsets.Tangent = vertexDesc.Stride;
+					}
+					vertexDesc.Stride += CompactTangentFrameSize;
+				}
+				for (size_t i = 0; i < size(HasTextureCoordinates); i++) {
+					if (HasTextureCoordinates[i]) {
+						vertexDesc.AttributeOffsets.TextureCoordinates[i] = vertexDesc.Stride;
+						vertexDesc.Stride += CompactTextureCoordinateSize;
+					}
+				}
+				return vertexDesc;
+			}
 			return {
 				.Stride = sizeof(VertexType),
 				.AttributeOffsets{
@@ -64,6 +117,15 @@ export {
 
 		shared_ptr<GPUBuffer> SkeletalTransforms;
 
+		// Levels of detail of the node, each made of the same level of every mesh
+		uint32_t GetLODCount() const {
+			size_t LODCount = 1;
+			for (const auto& mesh : Meshes) {
+				LODCount = max(LODCount, size(mesh->LODs) + 1);
+			}
+			return static_cast<uint32_t>(LODCount);
+		}
+
 		using DestroyEvent = CallbackList<void(MeshNode*)>;
 		DestroyEvent OnDestroyed;
 
@@ -78,7 +140,7 @@ export {
 		shared_ptr<SkinJointDictionary> SkinJoints;
 
 		vector<Material> Materials;
-		vector<array<tuple<shared_ptr<Texture>, uint32_t/*TextureCoordinateIndex*/>, TextureMapType::Count>> Textures;
+		vector<array<tuple<shared_ptr<Texture>, uint32_t/*TextureCoordinateIndex*/, uint32_t/*ArraySlice*/>, TextureMapType::Count>> Textures;
 
 		Model() = default;
 
@@ -113,6 +175,9 @@ export {
 
 							newMesh->Indices = mesh->Indices;
 							newMesh->SkeletalVertices = mesh->SkeletalVertices;
+							newMesh->Has8BitJoints = mesh->Has8BitJoints;
+							newMesh->Has8BitWeights = mesh->Has8BitWeights;
+							newMesh->Bounds = mesh->Bounds;
 							newMesh->HasNormals = mesh->HasNormals;
 							newMesh->HasTangents = mesh->HasTangents;
 							ranges::copy(mesh->HasTextureCoordinates, newMesh->HasTextureCoordinates);
@@ -0,0 +1,532 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+
+#include "directx/d3d12.h"
+
+#include "directxtk12/SimpleMath.h"
+
+#include "DirectXTex.h"
+
+export module ModelData;
+
+import CommandList;
+import ErrorHelpers;
+import GPUBuffer;
+import Material;
+import Model;
+import TextureCompression;
+import TextureHelpers;
+import TextureStreaming;
+import Vertex;
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace DirectX::SimpleMath;
+using namespace DirectX::TextureHelpers;
+using namespace ErrorHelpers;
+using namespace std;
+
+export {
+	struct MeshLODData {
+		// Same format as the indices of the mesh, into the same vertices
+		vector<uint8_t> Indices;
+
+		// See Mesh::LOD::Error
+		float Error{};
+	};
+
+	struct MeshData {
+		vector<Mesh::VertexType> Vertices;
+
+		vector<uint8_t> Indices;
+		DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
+
+		vector<Mesh::SkeletalVertexType> SkeletalVertices;
+
+		// From finest to coarsest, see GenerateLODs
+		vector<MeshLODData> LODs;
+
+		bool HasNormals{}, HasTangents{}, HasTextureCoordinates[2]{};
+
+		uint32_t MaterialIndex = ~0u, TextureIndex = ~0u;
+
+		auto GetIndexCount() const { return size(Indices) / (IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t)); }
+	};
+
+	struct MeshNodeData {
+		string NodeName, MeshName;
+
+		vector<MeshData> Meshes;
+
+		Matrix GlobalTransform;
+
+		uint32_t SkinIndex = ~0u;
+	};
+
+	struct ImageData {
+		shared_ptr<ScratchImage> Image;
+
+		uint32_t TextureMapType = ::TextureMapType::BaseColor;
+
+		// Identifies the image content, empty if unknown
+		TextureKey Key;
+	};
+
+	struct TextureMapData { uint32_t ImageIndex = ~0u, TextureCoordinateIndex{}; };
+
+	// CPU-side model that has been fully decoded but not uploaded yet
+	struct ModelData {
+		string Name;
+
+		vector<MeshNodeData> MeshNodes;
+
+		vector<vector<SkinJoint>> Skins;
+
+		vector<Material> Materials;
+		vector<array<TextureMapData, TextureMapType::Count>> Textures;
+
+		vector<ImageData> Images;
+
+		// Bytes of decoded geometry and pixels
+		size_t GetSize() const {
+			size_t size = 0;
+			for (const auto& meshNode : MeshNodes) {
+				for (const auto& mesh : meshNode.Meshes) {
+					size += span(mesh.Vertices).size_bytes() + std::size(mesh.Indices) + span(mesh.SkeletalVertices).size_bytes();
+					for (const auto& LOD : mesh.LODs) {
+						size += std::size(LOD.Indices);
+					}
+				}
+			}
+			for (const auto& image : Images) {
+				if (image.Image) {
+					size += image.Image->GetPixelsSize();
+				}
+			}
+			return size;
+		}
+	};
+
+	constexpr DXGI_FORMAT GetBlockCompressedFormat(uint32_t textureMapType) {
+		switch (textureMapType) {
+			case TextureMapType::Metallic:
+			case TextureMapType::Roughness:
+			case TextureMapType::Transmission: return DXGI_FORMAT_BC4_UNORM;
+			case TextureMapType::Normal: return DXGI_FORMAT_BC5_UNORM;
+			default: return DXGI_FORMAT_BC7_UNORM;
+		}
+	}
+
+	struct TexturePackingDesc {
+		bool IsEnabled{};
+
+		// Images of a model whose width and height are both at most MaxSize are packed with the ones of the same format, size and mip count
+		uint32_t MaxSize = 512;
+	};
+
+	/*
+	 * Uploads images into the slices of a single 2D array texture, in order.
+	 * Every image must have a single 2D item of the format, size and mip count of the first one.
+	 */
+	shared_ptr<Texture> LoadTextureArray(span<const ImageData* const> images, CommandList& commandList) {
+		const auto& metadata = images.front()->Image->GetMetadata();
+		ScratchImage textureArray;
+		ThrowIfFailed(textureArray.Initialize2D(metadata.format, metadata.width, metadata.height, size(images), metadata.mipLevels));
+		for (size_t slice = 0; const auto image : images) {
+			for (size_t level = 0; level < metadata.mipLevels; level++) {
+				const auto& source = *image->Image->GetImage(level, 0, 0);
+				memcpy(textureArray.GetImage(level, slice, 0)->pixels, source.pixels, source.slicePitch);
+			}
+			slice++;
+		}
+
+		shared_ptr texture = LoadTexture(commandList, textureArray);
+		texture->CreateSRV(true);
+		return texture;
+	}
+
+	/*
+	 * Textures shared by every model of a scene, keyed by ImageData::Key.
+	 * With a streamer, single textures only get their tail uploaded, and are handed to it by CommitStreamedTextures.
+	 */
+	class TextureCache {
+	public:
+		explicit TextureCache(const TexturePackingDesc& texturePacking = {}, TextureStreamer* textureStreamer = nullptr) :
+			m_texturePacking(texturePacking), m_textureStreamer(textureStreamer) {}
+
+		const TexturePackingDesc& GetTexturePacking() const noexcept { return m_texturePacking; }
+
+		shared_ptr<Texture> Load(const ImageData& imageData, CommandList& commandList) {
+			return Load(imageData.Key, [&] {
+				if (m_textureStreamer != nullptr) {
+					if (auto pendingTexture = m_textureStreamer->LoadTail(commandList, *imageData.Image)) {
+						auto texture = pendingTexture->Texture;
+
+						const scoped_lock lock(m_mutex);
+
+						m_pendingStreamedTextures.emplace_back(&commandList, move(*pendingTexture));
+						return texture;
+					}
+				}
+
+				shared_ptr texture = LoadTexture(commandList, *imageData.Image);
+				texture->CreateSRV(true);
+				return texture;
+			});
+		}
+
+		// Streams the textures whose tails were recorded on commandList; call once it has finished
+		void CommitStreamedTextures(const CommandList& commandList) {
+			const scoped_lock lock(m_mutex);
+
+			erase_if(m_pendingStreamedTextures, [&](auto& pendingTexture) {
+				if (pendingTexture.first != &commandList) {
+					return false;
+				}
+				m_textureStreamer->Add(move(pendingTexture.second));
+				return true;
+			});
+		}
+
+		// Array textures are keyed by the keys of all their images in order, and not cached if any of them is unknown
+		shared_ptr<Texture> Load(span<const ImageData* const> images, CommandList& commandList) {
+			const auto Create = [&] { return LoadTextureArray(images, commandList); };
+
+			vector<std::byte> digests;
+			digests.reserve(size(images) * sizeof(TextureKey::Digest));
+			for (const auto image : images) {
+				if (!image->Key) {
+					return Create();
+				}
+				digests.insert(cend(digests), cbegin(image->Key.Digest), cend(image->Key.Digest));
+			}
+			return Load(GetTextureKey(digests, size(images)), Create);
+		}
+
+		void Clear() {
+			const scoped_lock lock(m_mutex);
+
+			m_textures.clear();
+		}
+
+	private:
+		TexturePackingDesc m_texturePacking;
+
+		TextureStreamer* m_textureStreamer;
+
+		mutex m_mutex;
+		unordered_map<TextureKey, shared_future<shared_ptr<Texture>>, TextureKey::Hasher> m_textures;
+		vector<pair<const CommandList*, TextureStreamer::PendingTexture>> m_pendingStreamedTextures;
+
+		template <typename Creator>
+		shared_ptr<Texture> Load(const TextureKey& key, Creator&& create) {
+			if (!key) {
+				return create();
+			}
+
+			promise<shared_ptr<Texture>> promise;
+			shared_future<shared_ptr<Texture>> future;
+			bool isOwner;
+			{
+				const scoped_lock lock(m_mutex);
+
+				auto& texture = m_textures[key];
+				isOwner = !texture.valid();
+				if (isOwner) {
+					texture = promise.get_future().share();
+				}
+				future = texture;
+			}
+
+			if (isOwner) {
+				try {
+					promise.set_value(create());
+				}
+				catch (...) {
+					promise.set_exception(current_exception());
+				}
+			}
+
+			return future.get();
+		}
+	};
+
+	// Skinned meshes keep the full vertex layout, which skinning writes every frame
+	shared_ptr<Mesh> CreateMesh(const MeshData& meshData, CommandList& commandList, bool useCompactVertices = false) {
+		const auto mesh = make_shared<Mesh>();
+
+		mesh->HasNormals = meshData.HasNormals;
+		mesh->HasTangents = meshData.HasTangents;
+		ranges::copy(meshData.HasTextureCoordinates, mesh->HasTextureCoordinates);
+		mesh->MaterialIndex = meshData.MaterialIndex;
+		mesh->TextureIndex = meshData.TextureIndex;
+
+		const auto& deviceContext = commandList.GetDeviceContext();
+
+		// Every buffer of the mesh is uploaded through one staging allocation
+		vector<BufferCopy> copies;
+		copies.reserve(3 + size(meshData.LODs));
+
+		const auto CreateBuffer = [&](auto& buffer, const auto& data, bool isStructuredSRV = true, DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN) {
+			using T = typename remove_cvref_t<decltype(data)>::value_type;
+			buffer = GPUBuffer::CreateDefault<T>(deviceContext, size(data), format);
+			buffer->CreateSRV(
+				format == DXGI_FORMAT_UNKNOWN ?
+				(isStructuredSRV ? BufferSRVType::Structured : BufferSRVType::Raw) : BufferSRVType::Typed
+			);
+			if (::data(data) != nullptr) {
+				copies.emplace_back(BufferCopy{ *buffer, ::data(data), span(data).size_bytes() });
+			}
+		};
+
+		// Outlives the copies below, which read from it
+		vector<uint32_t> compactVertices;
+		if (useCompactVertices && empty(meshData.SkeletalVertices) && !empty(meshData.Vertices)) {
+			mesh->IsCompact = true;
+
+			auto minPosition = XMVectorReplicate(FLT_MAX), maxPosition = XMVectorReplicate(-FLT_MAX);
+			for (const auto& vertex : meshData.Vertices) {
+				const auto position = XMLoadFloat3(&vertex.Position);
+				minPosition = XMVectorMin(minPosition, position);
+				maxPosition = XMVectorMax(maxPosition, position);
+			}
+			const auto offset = (minPosition + maxPosition) * 0.5f, scale = XMVectorMax((maxPosition - minPosition) * 0.5f, XMVectorReplicate(FLT_MIN));
+			XMStoreFloat3(&mesh->PositionOffset, offset);
+			XMStoreFloat3(&mesh->PositionScale, scale);
+
+			const auto stride = mesh->GetCompactVertexStride();
+			compactVertices.resize(size(meshData.Vertices) * stride / sizeof(uint32_t));
+			for (auto pVertex = reinterpret_cast<std::byte*>(data(compactVertices)); const auto & vertex : meshData.Vertices) {
+				auto pAttribute = pVertex;
+				const auto Write = [&](const auto& value) {
+					memcpy(pAttribute, &value, sizeof(value));
+					pAttribute += sizeof(value);
+				};
+
+				XMSHORTN4 position;
+				XMStoreShortN4(&position, XMVectorSetW((XMLoadFloat3(&vertex.Position) - offset) / scale, 0));
+				Write(position);
+				if (meshData.HasNormals) {
+					Write(EncodeTangentFrame(vertex.Normal, meshData.HasTangents ? &vertex.Tangent : nullptr));
+				}
+				for (size_t i = 0; i < size(meshData.HasTextureCoordinates); i++) {
+					if (meshData.HasTextureCoordinates[i]) {
+						Write(vertex.TextureCoordinates[i]);
+					}
+				}
+
+				pVertex += stride;
+			}
+
+			mesh->Vertices = make_unique<GPUBuffer>(
+				deviceContext,
+				GPUBuffer::CreationDesc{ .Size = span(compactVertices).size_bytes(), .Stride = stride }
+			);
+			mesh->Vertices->CreateSRV(BufferSRVType::Raw);
+			copies.emplace_back(BufferCopy{ *mesh->Vertices, data(compactVertices), span(compactVertices).size_bytes() });
+		}
+		else {
+			CreateBuffer(mesh->Vertices, meshData.Vertices, false);
+		}
+
+		const auto CreateIndexBuffer = [&](auto& buffer, const vector<uint8_t>& indices) {
+			if (meshData.IndexFormat == DXGI_FORMAT_R16_UINT) {
+				CreateBuffer(buffer, span(reinterpret_cast<const uint16_t*>(data(indices)), size(indices) / sizeof(uint16_t)), true, meshData.IndexFormat);
+			}
+			else {
+				CreateBuffer(buffer, span(reinterpret_cast<const uint32_t*>(data(indices)), size(indices) / sizeof(uint32_t)), true, meshData.IndexFormat);
+			}
+		};
+		CreateIndexBuffer(mesh->Indices, meshData.Indices);
+
+		mesh->LODs.reserve(size(meshData.LODs));
+		for (const auto& LOD : meshData.LODs) {
+			auto& _LOD = mesh->LODs.emplace_back(Mesh::LOD{ .Error = LOD.Error });
+			CreateIndexBuffer(_LOD.Indices, LOD.Indices);
+		}
+
+		if (!empty(meshData.Vertices)) {
+			BoundingSphere::CreateFromPoints(mesh->Bounds, size(meshData.Vertices), &meshData.Vertices[0].Position, sizeof(Mesh::VertexType));
+		}
+
+		// Joints are stored with 8 bits wherever they fit, and weights wherever they stay within SkinDesc::Max8BitWeightError
+		vector<uint32_t> skeletalVertices;
+		if (!empty(meshData.SkeletalVertices)) {
+			mesh->Has8BitJoints = ranges::all_of(meshData.SkeletalVertices, [](const Mesh::SkeletalVertexType& vertex) {
+				return max({ vertex.Joints.x, vertex.Joints.y, vertex.Joints.z, vertex.Joints.w }) <= UINT8_MAX;
+			});
+			mesh->Has8BitWeights = ranges::all_of(meshData.SkeletalVertices, [](const Mesh::SkeletalVertexType& vertex) {
+				return SkinDesc::GetWeightError(vertex.Weights, true) <= SkinDesc::Max8BitWeightError;
+			});
+
+			const auto skinDesc = mesh->GetSkinDesc();
+			skeletalVertices.resize(size(meshData.SkeletalVertices) * skinDesc.Stride / sizeof(uint32_t));
+			for (auto pVertex = reinterpret_cast<std::byte*>(data(skeletalVertices)); const auto & vertex : meshData.SkeletalVertices) {
+				skinDesc.Encode(vertex, pVertex);
+				pVertex += skinDesc.Stride;
+			}
+
+			mesh->SkeletalVertices = make_unique<GPUBuffer>(
+				deviceContext,
+				GPUBuffer::CreationDesc{ .Size = span(skeletalVertices).size_bytes(), .Stride = skinDesc.Stride }
+			);
+			copies.emplace_back(BufferCopy{ *mesh->SkeletalVertices, data(skeletalVertices), span(skeletalVertices).size_bytes() });
+
+			CreateBuffer(mesh->MotionVectors, span(static_cast<const Mesh::MotionVectorType*>(nullptr), size(meshData.Vertices)));
+		}
+
+		commandList.Copy(copies);
+
+		for (const auto& buffer : { mesh->Vertices, mesh->Indices, mesh->SkeletalVertices, mesh->MotionVectors }) {
+			if (buffer) {
+				commandList.SetState(*buffer, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+			}
+		}
+		for (const auto& LOD : mesh->LODs) {
+			commandList.SetState(*LOD.Indices, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+		}
+
+		return mesh;
+	}
+
+	// With useCompactVertices, meshes without skinning store quantized positions and packed tangent frames, see VertexDesc::IsCompact
+	void CreateModel(Model& model, const ModelData& modelData, CommandList& commandList, TextureCache* textureCache = nullptr, bool useCompactVertices = false) {
+		const auto& deviceContext = commandList.GetDeviceContext();
+
+		model.Name = modelData.Name;
+
+		vector<shared_ptr<Texture>> textures(size(modelData.Images));
+		vector<uint32_t> arraySlices(size(modelData.Images));
+
+		// Fewer, larger textures mean fewer descriptors and neighboring rays sampling the same one more often
+		if (textureCache != nullptr && textureCache->GetTexturePacking().IsEnabled) {
+			const auto maxSize = textureCache->GetTexturePacking().MaxSize;
+			map<tuple<DXGI_FORMAT, size_t, size_t, size_t>, vector<uint32_t>> groups;
+			for (uint32_t i = 0; const auto & image : modelData.Images) {
+				if (const auto& metadata = image.Image->GetMetadata();
+					metadata.dimension == TEX_DIMENSION_TEXTURE2D && metadata.arraySize == 1 && !metadata.IsCubemap()
+					&& metadata.width <= maxSize && metadata.height <= maxSize) {
+					groups[{ metadata.format, metadata.width, metadata.height, metadata.mipLevels }].emplace_back(i);
+				}
+				i++;
+			}
+
+			for (const auto& imageIndices : groups | views::values) {
+				for (size_t first = 0; first + 1 < size(imageIndices); first += D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION) {
+					const auto count = min<size_t>(size(imageIndices) - first, D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION);
+					vector<const ImageData*> images;
+					images.reserve(count);
+					for (size_t i = 0; i < count; i++) {
+						images.emplace_back(&modelData.Images[imageIndices[first + i]]);
+					}
+
+					const auto texture = textureCache->Load(images, commandList);
+					for (uint32_t slice = 0; slice < count; slice++) {
+						const auto imageIndex = imageIndices[first + slice];
+						textures[imageIndex] = texture;
+						arraySlices[imageIndex] = slice;
+					}
+				}
+			}
+		}
+
+		for (size_t i = 0; const auto & image : modelData.Images) {
+			if (auto& texture = textures[i++]; !texture) {
+				if (textureCache != nullptr) {
+					texture = textureCache->Load(image, commandList);
+				}
+				else {
+					texture = LoadTexture(commandList, *image.Image);
+					texture->CreateSRV(true);
+				}
+			}
+		}
+
+		model.Materials = modelData.Materials;
+
+		model.Textures.reserve(size(modelData.Textures));
+		for (const auto& textureMaps : modelData.Textures) {
+			auto& _textureMaps = model.Textures.emplace_back();
+			for (size_t i = 0; const auto & [ImageIndex, TextureCoordinateIndex] : textureMaps) {
+				if (ImageIndex != ~0u) {
+					_textureMaps[i] = { textures.at(ImageIndex), TextureCoordinateIndex, arraySlices[ImageIndex] };
+				}
+				i++;
+			}
+		}
+
+		vector<shared_ptr<vector<SkinJoint>>> skins;
+		skins.reserve(size(modelData.Skins));
+		for (const auto& skin : modelData.Skins) {
+			skins.emplace_back(make_shared<vector<SkinJoint>>(skin));
+		}
+
+		model.MeshNodes.reserve(size(modelData.MeshNodes));
+		for (const auto& meshNodeData : modelData.MeshNodes) {
+			const auto meshNode = make_shared<MeshNode>();
+
+			meshNode->NodeName = meshNodeData.NodeName;
+			meshNode->MeshName = meshNodeData.MeshName;
+
+			meshNode->GlobalTransform = meshNodeData.GlobalTransform;
+
+			if (meshNodeData.SkinIndex != ~0u) {
+				const auto& skinJoints = skins.at(meshNodeData.SkinIndex);
+
+				if (!model.SkinJoints) {
+					model.SkinJoints = make_shared<SkinJointDictionary>();
+				}
+
+				(*model.SkinJoints)[meshNodeData.NodeName] = skinJoints;
+
+				if (!empty(*skinJoints)) {
+					meshNode->SkeletalTransforms = GPUBuffer::CreateDefault<XMFLOAT3X4>(deviceContext, size(*skinJoints));
+				}
+			}
+
+			meshNode->Meshes.reserve(size(meshNodeData.Meshes));
+			for (const auto& meshData : meshNodeData.Meshes) {
+				meshNode->Meshes.emplace_back(CreateMesh(meshData, commandList, useCompactVertices));
+			}
+
+			model.MeshNodes.emplace_back(meshNode);
+		}
+
+		// BLAS builds dequantize compact positions through the transform of their geometry, all of which share one buffer per model
+		vector<XMFLOAT3X4> positionTransforms;
+		vector<Mesh*> compactMeshes;
+		for (const auto& meshNode : model.MeshNodes) {
+			for (const auto& mesh : meshNode->Meshes) {
+				if (mesh->IsCompact) {
+					mesh->PositionTransformIndex = static_cast<uint32_t>(size(positionTransforms));
+					const auto& scale = mesh->PositionScale, & offset = mesh->PositionOffset;
+					positionTransforms.emplace_back(
+						scale.x, 0, 0, offset.x,
+						0, scale.y, 0, offset.y,
+						0, 0, scale.z, offset.z
+					);
+					compactMeshes.emplace_back(mesh.get());
+				}
+			}
+		}
+		if (!empty(positionTransforms)) {
+			const shared_ptr buffer = GPUBuffer::CreateDefault<XMFLOAT3X4>(deviceContext, size(positionTransforms));
+			commandList.Copy(*buffer, positionTransforms);
+			commandList.SetState(*buffer, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+			for (const auto mesh : compactMeshes) {
+				mesh->PositionTransforms = buffer;
+			}
+		}
+	}
+}
@@ -170,6 +170,24 @@ public:
 
 			sl::ReflexMode ReflexMode = sl::ReflexMode::eLowLatency;
 
+			bool IsProgressiveSceneLoadingEnabled{}, IsSceneHotReloadEnabled{}, IsTextureCompressionEnabled{}, IsTexturePackingEnabled{}, IsVertexCompressionEnabled{}, IsMeshLODEnabled{}, IsTextureStreamingEnabled{};
+
+			// Models, animations and textures kept across scene switches, in MiB
+			struct ResidentAssetCache {
+				static constexpr uint32_t MaxBudget = 65536;
+				uint32_t CPUBudget = 2048, GPUBudget = 4096;
+
+				FRIEND_JSON_CONVERSION_FUNCTIONS(ResidentAssetCache, CPUBudget, GPUBudget);
+			} ResidentAssetCache;
+
+			// Video memory for streamed textures, tails included, in MiB
+			struct TextureStreaming {
+				static constexpr uint32_t MaxBudget = 65536;
+				uint32_t Budget = 1024;
+
+				FRIEND_JSON_CONVERSION_FUNCTIONS(TextureStreaming, Budget);
+			} TextureStreaming;
+
 			struct Camera {
 				bool IsJitterEnabled = true;
 
@@ -335,11 +353,16 @@ public:
 				FRIEND_JSON_CONVERSION_FUNCTIONS(PostProcessing, SuperResolution, Denoising, IsDLSSFrameGenerationEnabled, NIS, Bloom, ToneMapping);
 			} PostProcessing;
 
-			FRIEND_JSON_CONVERSION_FUNCTIONS(Graphics, WindowMode, Resolution, IsHDREnabled, IsVSyncEnabled, ReflexMode, Camera, Raytracing, PostProcessing);
+			FRIEND_JSON_CONVERSION_FUNCTIONS(Graphics, WindowMode, Resolution, IsHDREnabled, IsVSyncEnabled, ReflexMode, IsProgressiveSceneLoadingEnabled, IsSceneHotReloadEnabled, IsTextureCompressionEnabled, IsTexturePackingEnabled, IsVertexCompressionEnabled, IsMeshLODEnabled, IsTextureStreamingEnabled, ResidentAssetCache, TextureStreaming, Camera, Raytracing, PostProcessing);
 
 			void Check() override {
 				using namespace std;
 
+				ResidentAssetCache.CPUBudget = min(ResidentAssetCache.CPUBudget, ResidentAssetCache.MaxBudget);
+				ResidentAssetCache.GPUBudget = min(ResidentAssetCache.GPUBudget, ResidentAssetCache.MaxBudget);
+
+				TextureStreaming.Budget = min(TextureStreaming.Budget, TextureStreaming.MaxBudget);
+
 				Camera.HorizontalFieldOfView = clamp(Camera.HorizontalFieldOfView, Camera.MinHorizontalFieldOfView, Camera.MaxHorizontalFieldOfView);
 
 				{
@@ -1,7 +1,7 @@
 module;
 
 #include <filesystem>
-#include <fstream>
+#include <span>
 
 #include <Windows.h>
 
@@ -15,12 +15,12 @@ export module MyScene;
 
 export import Scene;
 
-import ErrorHelpers;
 import JSONConverters;
+import MemoryMappedFile;
 import ResourceHelpers;
+import ScenePack;
 
 using namespace DirectX;
-using namespace ErrorHelpers;
 using namespace nlohmann;
 using namespace ResourceHelpers;
 using namespace std;
@@ -35,7 +35,276 @@ export {
 	JSON_CONVERSION_FUNCTIONS(decltype(SceneDesc::Camera), Position, Rotation);
 	JSON_CONVERSION_FUNCTIONS(decltype(SceneDesc::EnvironmentLight), Color, Rotation, Texture);
 	JSON_CONVERSION_FUNCTIONS(SceneDesc, Camera, EnvironmentLight, Models, Animations, RenderObjects);
+}
+
+namespace {
+	// Appends SAX events to a JSON value, in the manner of the DOM parser of nlohmann::json
+	class JSONBuilder {
+	public:
+		void Reset(ordered_json_f& root) {
+			m_root = &root;
+			m_stack.clear();
+		}
+
+		template <typename T>
+		void Add(T&& value) { AddValue(forward<T>(value)); }
+
+		void Start(ordered_json_f::value_t type) { m_stack.emplace_back(AddValue(type)); }
+
+		void Key(ordered_json_f::string_t& key) { m_element = &(*m_stack.back())[move(key)]; }
+
+		void End() { m_stack.pop_back(); }
+
+	private:
+		ordered_json_f* m_root{}, * m_element{};
+		vector<ordered_json_f*> m_stack;
+
+		template <typename T>
+		ordered_json_f* AddValue(T&& value) {
+			if (empty(m_stack)) {
+				*m_root = ordered_json_f(forward<T>(value));
+				return m_root;
+			}
+			if (auto& parent = *m_stack.back(); parent.is_array()) {
+				parent.emplace_back(forward<T>(value));
+				return &parent.back();
+			}
+			*m_element = ordered_json_f(forward<T>(value));
+			return m_element;
+		}
+	};
+
+	/*
+	 * Reads a scene description without building a DOM for RenderObjects, which can hold hundreds of thousands of entries:
+	 * each entry is filled in place as its members arrive, and only members that are objects or arrays, such as Transform,
+	 * go through a small temporary JSON value.
+	 * Everything else is collected into a regular JSON value and converted with from_json once parsing is done.
+	 */
+	class SceneDescReader : public nlohmann::json_sax<ordered_json_f> {
+	public:
+		// Distinct Model or Animation keys, each with the index of the first render object referencing it
+		using KeyDictionary = unordered_map<std::string, size_t>;
+
+		explicit SceneDescReader(SceneDesc& sceneDesc) : m_sceneDesc(sceneDesc) { m_document.Reset(m_documentValue); }
+
+		// Returns false on a syntax error, described by GetErrorMessage
+		bool Read(string_view json) {
+			if (!ordered_json_f::sax_parse(cbegin(json), cend(json), this)) {
+				return false;
+			}
+
+			from_json(m_documentValue, m_sceneDesc);
+
+			return true;
+		}
+
+		const auto& GetErrorMessage() const noexcept { return m_errorMessage; }
+
+		const KeyDictionary& GetModelKeys() const noexcept { return m_modelKeys; }
+		const KeyDictionary& GetAnimationKeys() const noexcept { return m_animationKeys; }
+
+		bool null() override { return AddScalar(nullptr); }
+
+		bool boolean(bool value) override {
+			if (IsRenderObjectMember() && m_key == "IsVisible") {
+				m_sceneDesc.RenderObjects.back().IsVisible = value;
+				return true;
+			}
+			return AddScalar(value);
+		}
 
+		bool number_integer(number_integer_t value) override { return AddScalar(value); }
+		bool number_unsigned(number_unsigned_t value) override { return AddScalar(value); }
+		bool number_float(number_float_t value, const string_t&) override { return AddScalar(value); }
+
+		bool string(string_t& value) override {
+			if (IsRenderObjectMember()) {
+				auto& renderObject = m_sceneDesc.RenderObjects.back();
+				if (m_key == "Name") {
+					renderObject.Name = move(value);
+					return true;
+				}
+				if (m_key == "Model") {
+					renderObject.Model = move(value);
+					AddKey(m_modelKeys, renderObject.Model);
+					return true;
+				}
+				if (m_key == "Animation") {
+					renderObject.Animation = move(value);
+					AddKey(m_animationKeys, renderObject.Animation);
+					return true;
+				}
+			}
+			return AddScalar(move(value));
+		}
+
+		bool binary(binary_t& value) override { return AddScalar(move(value)); }
+
+		bool start_object(size_t) override { return StartContainer(ordered_json_f::value_t::object); }
+		bool end_object() override { return EndContainer(); }
+
+		bool start_array(size_t) override { return StartContainer(ordered_json_f::value_t::array); }
+		bool end_array() override { return EndContainer(); }
+
+		bool key(string_t& value) override {
+			if (m_valueDepth) {
+				m_value.Key(value);
+			}
+			else if (m_region == Region::Document) {
+				m_key = value;
+				m_document.Key(value);
+			}
+			else {
+				m_key = move(value);
+			}
+			return true;
+		}
+
+		bool parse_error(size_t, const std::string&, const ordered_json_f::exception& exception) override {
+			m_errorMessage = exception.what();
+			return false;
+		}
+
+	private:
+		enum class Region { Document, RenderObjects, RenderObject };
+
+		SceneDesc& m_sceneDesc;
+
+		Region m_region = Region::Document;
+		size_t m_depth{};
+		std::string m_key, m_errorMessage;
+
+		ordered_json_f m_documentValue;
+		JSONBuilder m_document;
+
+		// Member of a render object being built as a JSON value, and the depth at which it started
+		ordered_json_f m_valueValue;
+		JSONBuilder m_value;
+		size_t m_valueDepth{};
+
+		KeyDictionary m_modelKeys, m_animationKeys;
+
+		bool IsRenderObjectMember() const noexcept { return !m_valueDepth && m_region == Region::RenderObject; }
+
+		// Records a key of the current render object for validation, so that each distinct key is checked once;
+		// render objects still own their copy of it
+		void AddKey(KeyDictionary& keys, const std::string& key) { keys.try_emplace(key, size(m_sceneDesc.RenderObjects) - 1); }
+
+		template <typename T>
+		bool AddScalar(T&& value) {
+			if (m_valueDepth) {
+				m_value.Add(forward<T>(value));
+			}
+			else {
+				switch (m_region) {
+					case Region::Document: m_document.Add(forward<T>(value)); break;
+					case Region::RenderObjects: AddRenderObject(); break;
+					case Region::RenderObject: SetRenderObjectMember(ordered_json_f(forward<T>(value))); break;
+				}
+			}
+			return true;
+		}
+
+		bool StartContainer(ordered_json_f::value_t type) {
+			m_depth++;
+
+			if (!m_valueDepth) {
+				switch (m_region) {
+					case Region::Document:
+						if (m_depth == 2 && m_key == "RenderObjects" && type == ordered_json_f::value_t::array) {
+							// The key has already reached the document, which must not see the array
+							m_documentValue.erase("RenderObjects");
+
+							// As with the DOM, a repeated key replaces what came before
+							m_sceneDesc.RenderObjects.clear();
+							m_modelKeys.clear();
+							m_animationKeys.clear();
+
+							m_region = Region::RenderObjects;
+						}
+						else {
+							m_document.Start(type);
+						}
+						return true;
+
+					case Region::RenderObjects:
+						if (type == ordered_json_f::value_t::object) {
+							AddRenderObject();
+							m_key.clear();
+
+							m_region = Region::RenderObject;
+
+							return true;
+						}
+						break;
+
+					case Region::RenderObject: break;
+				}
+
+				m_valueDepth = m_depth;
+				m_value.Reset(m_valueValue);
+			}
+
+			m_value.Start(type);
+
+			return true;
+		}
+
+		bool EndContainer() {
+			const auto depth = m_depth--;
+
+			if (m_valueDepth) {
+				m_value.End();
+
+				if (depth == m_valueDepth) {
+					m_valueDepth = 0;
+
+					if (m_region == Region::RenderObjects) {
+						AddRenderObject();
+					}
+					else {
+						SetRenderObjectMember(move(m_valueValue));
+					}
+				}
+			}
+			else {
+				switch (m_region) {
+					case Region::Document: m_document.End(); break;
+					case Region::RenderObjects: m_region = Region::Document; break;
+					case Region::RenderObject: m_region = Region::RenderObjects; break;
+				}
+			}
+
+			return true;
+		}
+
+		// Elements that are not objects leave a default render object, as from_json does
+		void AddRenderObject() { m_sceneDesc.RenderObjects.emplace_back(); }
+
+		void SetRenderObjectMember(ordered_json_f&& value) {
+			auto& renderObject = m_sceneDesc.RenderObjects.back();
+			if (m_key == "Name") {
+				value.get_to(renderObject.Name);
+			}
+			else if (m_key == "Transform") {
+				value.get_to(renderObject.Transform);
+			}
+			else if (m_key == "IsVisible") {
+				value.get_to(renderObject.IsVisible);
+			}
+			else if (m_key == "Model") {
+				value.get_to(renderObject.Model);
+				AddKey(m_modelKeys, renderObject.Model);
+			}
+			else if (m_key == "Animation") {
+				value.get_to(renderObject.Animation);
+				AddKey(m_animationKeys, renderObject.Animation);
+			}
+		}
+	};
+}
+
+export {
 	struct MySceneDesc : SceneDesc {
 		MySceneDesc(const path& filePath) {
 			if (empty(filePath)) {
@@ -44,17 +313,37 @@ export {
 
 			const auto filePathString = filePath.string();
 
-			ifstream file(filePath);
-			ThrowIfFailed(static_cast<BOOL>(file.is_open()));
+			const auto isScenePack = !_wcsicmp(filePath.extension().c_str(), L".scenepack");
+
+			shared_ptr<const ScenePackReader> scenePack;
+			unique_ptr<MemoryMappedFile> file;
+			if (isScenePack) {
+				scenePack = make_shared<const ScenePackReader>(filePath);
+			}
+			else {
+				file = make_unique<MemoryMappedFile>(filePath);
+			}
 
 			try {
-				ordered_json_f json;
-				file >> json;
-				reinterpret_cast<SceneDesc&>(*this) = json;
+				SceneDescReader reader(*this);
+				auto isRead = false;
+				if (isScenePack) {
+					isRead = reader.Read(scenePack->ReadSceneDesc());
+				}
+				else {
+					const auto data = file->GetData();
+					isRead = reader.Read({ reinterpret_cast<const char*>(::data(data)), size(data) });
+				}
+				if (!isRead) {
+					throw runtime_error(format("{}: {}", filePathString, reader.GetErrorMessage()));
+				}
+				ScenePack = scenePack;
 
-				for (const auto& renderObject : RenderObjects) {
-					const auto Check = [&](const char* name, const unordered_map<string, path>& resources, const string& URI) {
+				// Only distinct keys are checked, each against the first render object referencing it
+				const auto Check = [&](const char* name, const unordered_map<string, path>& resources, const SceneDescReader::KeyDictionary& keys) {
+					for (const auto& [URI, renderObjectIndex] : keys) {
 						if (!empty(URI) && !resources.contains(URI)) {
+							const auto& renderObject = RenderObjects[renderObjectIndex];
 							auto renderObjectInfo = "RenderObject"s;
 							if (empty(renderObject.Name)) {
 								renderObjectInfo = "Unnamed " + renderObjectInfo;
@@ -64,10 +353,10 @@ export {
 							}
 							throw runtime_error(format("{}: {}: {} {} not found", filePathString, renderObjectInfo, name, URI));
 						}
-					};
-					Check("Models", Models, renderObject.Model);
-					Check("Animations", Animations, renderObject.Animation);
-				}
+					}
+				};
+				Check("Models", Models, reader.GetModelKeys());
+				Check("Animations", Animations, reader.GetAnimationKeys());
 
 				const auto ResolvePath = [&](path& path) {
 					if (!empty(path) && !path.is_absolute()) {
@@ -92,7 +381,7 @@ export {
 	struct MyScene : Scene {
 		using Scene::Scene;
 
-		bool IsStatic() const override { return !m_isAnimationPlaying || empty(AnimationCollections); }
+		bool IsStatic() const override { return !m_isAnimationPlaying || !IsAnimated(); }
 
 		void Tick(double elapsedSeconds, const GamePad::ButtonStateTracker& gamepadStateTracker, const Keyboard::KeyboardStateTracker& keyboardStateTracker, const Mouse::ButtonStateTracker& mouseStateTracker) override {
 			if (mouseStateTracker.GetLastState().positionMode == Mouse::MODE_RELATIVE) {
@@ -0,0 +1,224 @@
+module;
+
+#include <filesystem>
+#include <list>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <typeinfo>
+#include <unordered_set>
+
+export module ResidentAssetCache;
+
+import Animation;
+import GPUBuffer;
+import GPUResource;
+import Model;
+import ScenePack;
+import Texture;
+
+using namespace DirectX;
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+	size_t GetCPUSize(const Model& model) {
+		size_t size = std::size(model.Materials) * sizeof(model.Materials[0]);
+		if (model.SkinJoints) {
+			for (const auto& skinJoints : *model.SkinJoints | views::values) {
+				size += std::size(*skinJoints) * sizeof(SkinJoint);
+			}
+		}
+		return size;
+	}
+
+	size_t GetCPUSize(const AnimationCollection& animationCollection) {
+		size_t size = 0;
+		for (const auto& animation : animationCollection) {
+			for (const auto& [Translations, Rotations, Scales] : animation.GetKeyframeCollections() | views::values) {
+				size += span(Translations).size_bytes() + span(Rotations).size_bytes() + span(Scales).size_bytes();
+			}
+		}
+		return size;
+	}
+
+	size_t GetCPUSize(const Texture&) { return 0; }
+
+	size_t GetGPUSize(const Model& model) {
+		// Textures and meshes may be shared between nodes, so each resource is counted once
+		unordered_set<const GPUResource*> resources;
+		for (const auto& meshNode : model.MeshNodes) {
+			for (const auto& mesh : meshNode->Meshes) {
+				resources.insert({ mesh->Vertices.get(), mesh->Indices.get(), mesh->SkeletalVertices.get(), mesh->MotionVectors.get(), mesh->PositionTransforms.get() });
+				for (const auto& LOD : mesh->LODs) {
+					resources.insert(LOD.Indices.get());
+				}
+			}
+			resources.insert(meshNode->SkeletalTransforms.get());
+		}
+		for (const auto& textureMaps : model.Textures) {
+			for (const auto& [Texture, _1, _2] : textureMaps) {
+				resources.insert(Texture.get());
+			}
+		}
+		resources.erase(nullptr);
+
+		size_t size = 0;
+		for (const auto resource : resources) {
+			size += resource->GetAllocationSize();
+		}
+		return size;
+	}
+
+	size_t GetGPUSize(const AnimationCollection&) { return 0; }
+
+	size_t GetGPUSize(const Texture& texture) { return texture.GetAllocationSize(); }
+}
+
+export {
+	/*
+	 * Keeps models, animation collections and textures alive across scenes so that assets seen before are not reloaded.
+	 * Entries are keyed by the canonical path and last write time of their file, so edited files miss the cache,
+	 * and are evicted in least recently used order once the CPU or GPU budget is exceeded.
+	 * Entries still referenced outside the cache are never evicted, as dropping them would not free any memory.
+	 */
+	class ResidentAssetCache {
+	public:
+		struct Budget { size_t CPU, GPU; };
+
+		struct Usage {
+			size_t EntryCount, CPU, GPU;
+		};
+
+		explicit ResidentAssetCache(const Budget& budget) : m_budget(budget) {}
+
+		// Returns an empty key if the file cannot be found; such assets are never cached
+		static wstring GetKey(const path& filePath, const ScenePackReader* scenePack) {
+			const auto& file = scenePack != nullptr ? scenePack->GetFilePath() : filePath;
+
+			error_code errorCode;
+			const auto canonicalPath = weakly_canonical(file, errorCode);
+			if (errorCode) {
+				return {};
+			}
+			const auto lastWriteTime = last_write_time(canonicalPath, errorCode);
+			if (errorCode) {
+				return {};
+			}
+
+			auto key = format(L"{}|{}", canonicalPath.native(), lastWriteTime.time_since_epoch().count());
+			if (scenePack != nullptr) {
+				key += L'|' + filePath.lexically_relative(file.parent_path()).lexically_normal().generic_wstring();
+			}
+			return key;
+		}
+
+		template <typename T> requires is_same_v<T, Model> || is_same_v<T, AnimationCollection> || is_same_v<T, Texture>
+		shared_ptr<T> Find(const wstring& key) {
+			if (empty(key)) {
+				return nullptr;
+			}
+
+			const scoped_lock lock(m_mutex);
+
+			const auto pEntry = m_entries.find({ &typeid(T), key });
+			if (pEntry == cend(m_entries)) {
+				return nullptr;
+			}
+			m_LRUList.splice(cbegin(m_LRUList), m_LRUList, pEntry->second);
+			return static_pointer_cast<T>(pEntry->second->Resource);
+		}
+
+		template <typename T> requires is_same_v<T, Model> || is_same_v<T, AnimationCollection> || is_same_v<T, Texture>
+		void Add(const wstring& key, const shared_ptr<T>& resource) {
+			if (empty(key) || !resource) {
+				return;
+			}
+
+			const Entry entry{
+				.Type = &typeid(T),
+				.Key = key,
+				.Resource = resource,
+				.CPUSize = GetCPUSize(*resource),
+				.GPUSize = GetGPUSize(*resource)
+			};
+
+			const scoped_lock lock(m_mutex);
+
+			if (const auto pEntry = m_entries.find({ entry.Type, key }); pEntry != cend(m_entries)) {
+				Erase(pEntry->second);
+			}
+
+			m_LRUList.emplace_front(entry);
+			m_entries.emplace(pair(entry.Type, key), cbegin(m_LRUList));
+			m_usage.EntryCount++;
+			m_usage.CPU += entry.CPUSize;
+			m_usage.GPU += entry.GPUSize;
+
+			TrimUnlocked();
+		}
+
+		void SetBudget(const Budget& budget) {
+			const scoped_lock lock(m_mutex);
+
+			m_budget = budget;
+
+			TrimUnlocked();
+		}
+
+		// Call after releasing a scene so that entries it no longer references can be evicted
+		void Trim() {
+			const scoped_lock lock(m_mutex);
+
+			TrimUnlocked();
+		}
+
+		void Clear() {
+			const scoped_lock lock(m_mutex);
+
+			m_entries.clear();
+			m_LRUList.clear();
+			m_usage = {};
+		}
+
+		Usage GetUsage() const {
+			const scoped_lock lock(m_mutex);
+
+			return m_usage;
+		}
+
+	private:
+		struct Entry {
+			const type_info* Type;
+			wstring Key;
+			shared_ptr<void> Resource;
+			size_t CPUSize, GPUSize;
+		};
+
+		Budget m_budget;
+		Usage m_usage{};
+
+		mutable mutex m_mutex;
+
+		// Most recently used first
+		list<Entry> m_LRUList;
+		map<pair<const type_info*, wstring>, list<Entry>::const_iterator> m_entries;
+
+		void Erase(list<Entry>::const_iterator entry) {
+			m_usage.EntryCount--;
+			m_usage.CPU -= entry->CPUSize;
+			m_usage.GPU -= entry->GPUSize;
+			m_entries.erase({ entry->Type, entry->Key });
+			m_LRUList.erase(entry);
+		}
+
+		void TrimUnlocked() {
+			for (auto entry = cend(m_LRUList); entry != cbegin(m_LRUList) && (m_usage.CPU > m_budget.CPU || m_usage.GPU > m_budget.GPU);) {
+				if ((--entry)->Resource.use_count() == 1) {
+					Erase(entry++);
+				}
+			}
+		}
+	};
+}
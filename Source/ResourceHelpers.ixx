@@ -1,20 +1,18 @@
 module;
 
 #include <filesystem>
-#include <latch>
-#include <mutex>
+#include <future>
 #include <ranges>
-#include <thread>
 #include <unordered_map>
 #include <vector>
 
 export module ResourceHelpers;
 
-import ErrorHelpers;
+import ThreadPool;
 
-using namespace ErrorHelpers;
 using namespace std;
 using namespace std::filesystem;
+using namespace ThreadHelpers;
 
 export namespace ResourceHelpers {
 	bool AreSamePath(const path& a, const path& b) {
@@ -30,86 +28,67 @@ export namespace ResourceHelpers {
 		return path.is_absolute() ? path : filesystem::path(*__wargv).replace_filename(path);
 	}
 
+	// Returns the default value if the file cannot be queried
+	file_time_type GetLastWriteTime(const path& filePath) {
+		error_code errorCode;
+		const auto lastWriteTime = last_write_time(filePath, errorCode);
+		return errorCode ? file_time_type() : lastWriteTime;
+	}
+
+	// Returns a path that is identical for every spelling of the same file, for use as a lookup key
+	path GetCanonicalPath(const path& filePath) {
+		error_code errorCode;
+		auto canonicalPath = weakly_canonical(filePath, errorCode);
+		return errorCode ? filePath.lexically_normal() : canonicalPath;
+	}
+
 	template <typename KeyType, typename ResourceType, constructible_from Loader> requires is_class_v<Loader>
 	struct ResourceDictionary : unordered_map<KeyType, shared_ptr<ResourceType>> {
+		// Files referenced by several keys are loaded once and shared; loading runs on the shared thread pool
 		template <typename... Args>
-		void Load(const unordered_map<KeyType, path>& descs, bool ignoreLoaded, size_t threadCount, Args&&... args) {
-			if (!threadCount) {
-				Throw<out_of_range>("Thread count cannot be 0");
-			}
-
-			vector<thread> threads;
-
-			struct LoadedResource {
+		void Load(const unordered_map<KeyType, path>& descs, bool ignoreLoaded, Args&&... args) {
+			struct Group {
 				path FilePath;
-				shared_ptr<ResourceType>* Resource;
+				vector<shared_ptr<ResourceType>*> Resources;
 			};
-			vector<pair<size_t, LoadedResource>> loadedResources;
-
-			exception_ptr exception;
-
-			vector<unique_ptr<latch>> latches;
-			mutex loadedResourcesMutex, exceptionMutex;
-
-			for (size_t globalThreadIndex = 0; const auto & [URI, FilePath] : descs) {
-				latches.emplace_back(make_unique<latch>(1));
-
-				(*this)[URI];
-				threads.emplace_back(
-					[&, globalThreadIndex](size_t localThreadIndex) {
-						try {
-					const auto filePath = ResolveResourcePath(FilePath);
-
-					auto& resource = this->at(URI);
-
-					{
-						const scoped_lock lock(loadedResourcesMutex);
-
-						if (const auto pLoadedResource = ranges::find_if(loadedResources, [&](const auto& value) { return AreSamePath(value.second.FilePath, filePath); });
-							pLoadedResource != ::cend(loadedResources)) {
-							if (pLoadedResource->first < localThreadIndex) {
-								latches[pLoadedResource->first]->wait();
-							}
+			unordered_map<path, Group> groups;
+			for (const auto& [Key, FilePath] : descs) {
+				const auto filePath = ResolveResourcePath(FilePath);
+				auto& group = groups[GetCanonicalPath(filePath)];
+				if (empty(group.FilePath)) {
+					group.FilePath = filePath;
+				}
+				group.Resources.emplace_back(&(*this)[Key]);
+			}
 
-							resource = *pLoadedResource->second.Resource;
+			auto& threadPool = ThreadPool::GetDefault();
 
-							return;
+			vector<future<void>> futures;
+			futures.reserve(size(groups));
+			for (auto& group : groups | views::values) {
+				if (ignoreLoaded) {
+					if (const auto pResource = ranges::find_if(group.Resources, [](const auto& value) { return *value != nullptr; });
+						pResource != cend(group.Resources)) {
+						for (const auto resource : group.Resources) {
+							*resource = **pResource;
 						}
-
-						loadedResources.emplace_back(globalThreadIndex, LoadedResource{ .FilePath = filePath, .Resource = &resource });
+						continue;
 					}
-
-					if (!ignoreLoaded || !resource) {
-						resource = make_shared<ResourceType>();
-						Loader()(*resource, filePath, forward<Args>(args)...);
-					}
-
-					latches[localThreadIndex]->count_down();
 				}
-				catch (...) {
-					const scoped_lock lock(exceptionMutex);
 
-					if (!exception) {
-						exception = current_exception();
+				futures.emplace_back(threadPool.Submit([&] {
+					const auto resource = make_shared<ResourceType>();
+					Loader()(*resource, group.FilePath, args...);
+					for (const auto _resource : group.Resources) {
+						*_resource = resource;
 					}
-				}
-					},
-					size(threads)
-						);
-
-				globalThreadIndex++;
+				}));
+			}
 
-				if (size(threads) == threadCount || globalThreadIndex == size(descs)) {
-					for (auto& thread : threads) {
-						thread.join();
-					}
-					threads.clear();
-					latches.clear();
-				}
+			threadPool.Wait(futures);
 
-				if (exception) {
-					rethrow_exception(exception);
-				}
+			for (auto& future : futures) {
+				future.get();
 			}
 		}
 	};
@@ -1,6 +1,17 @@
 module;
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <thread>
 
 #include "directxtk12/GamePad.h"
 #include "directxtk12/Keyboard.h"
@@ -9,16 +20,26 @@ module;
 
 #include "rtxmu/D3D12AccelStructManager.h"
 
+#include "DirectXTex.h"
+
 export module Scene;
 
 import CommandList;
 import DeviceContext;
 import GLTFHelpers;
 import Math;
+import MemoryMappedFile;
+import MeshOptimization;
+import MipChainGeneration;
 import RaytracingHelpers;
+import ResidentAssetCache;
 import ResourceHelpers;
+import ScenePack;
 import SkeletalMeshSkinning;
+import TextureCompression;
 import TextureHelpers;
+import TextureStreaming;
+import ThreadHelpers;
 
 using namespace DirectX;
 using namespace DirectX::RaytracingHelpers;
@@ -26,8 +47,10 @@ using namespace DirectX::SimpleMath;
 using namespace Math;
 using namespace ResourceHelpers;
 using namespace std;
+using namespace std::chrono;
 using namespace std::filesystem;
 using namespace TextureHelpers;
+using namespace ThreadHelpers;
 
 export {
 	struct RenderObjectBase {
@@ -70,6 +93,9 @@ export {
 		unordered_map<string, path> Models, Animations;
 
 		vector<RenderObjectDesc> RenderObjects;
+
+		// Set when the scene is read from a scene pack; resource paths then refer to its chunks
+		shared_ptr<const ScenePackReader> ScenePack;
 	};
 
 	struct Scene : SceneBase {
@@ -83,26 +109,70 @@ export {
 		} EnvironmentLight;
 
 		struct ModelDictionaryLoader {
-			void operator()(Model& resource, const path& filePath, const DeviceContext& deviceContext) const {
+			void operator()(
+				Model& resource, const path& filePath,
+				const DeviceContext& deviceContext,
+				GLTFHelpers::AssetCache& assetCache, GLTFHelpers::ImageCache& imageCache, TextureCache& textureCache,
+				const ScenePackReader* scenePack, const MeshOptimizationDesc& meshOptimization
+			) const {
 				CommandList commandList(deviceContext);
 				commandList.Begin();
 
-				GLTFHelpers::LoadModel(resource, filePath, commandList, true);
+				if (scenePack != nullptr) {
+					ModelData modelData;
+					ReadModel(*scenePack, modelData, filePath, meshOptimization);
+					CreateModel(resource, modelData, commandList, &textureCache);
+				}
+				else {
+					GLTFHelpers::LoadModel(resource, *assetCache.Load(filePath), commandList, true, &imageCache, &textureCache, meshOptimization);
+				}
 
 				commandList.End();
+
+				textureCache.CommitStreamedTextures(commandList);
 			}
 		};
 		ResourceDictionary<string, Model, ModelDictionaryLoader> Models;
 
 		struct AnimationCollectionDictionaryLoader {
-			void operator()(AnimationCollection& resource, const path& filePath) const {
-				GLTFHelpers::LoadAnimation(resource, filePath);
+			void operator()(AnimationCollection& resource, const path& filePath, GLTFHelpers::AssetCache& assetCache, const ScenePackReader* scenePack) const {
+				if (scenePack != nullptr) {
+					scenePack->ReadAnimationCollection(resource, filePath);
+				}
+				else {
+					GLTFHelpers::LoadAnimation(resource, *assetCache.Load(filePath));
+				}
 			}
 		};
 		ResourceDictionary<string, AnimationCollection, AnimationCollectionDictionaryLoader> AnimationCollections;
 
 		vector<RenderObject> RenderObjects;
 
+		// Applies to textures imported by subsequent loads and reloads; textures of scene packs are compressed when cooked
+		TextureCompressionDesc TextureCompression;
+
+		// Applies to models uploaded by subsequent loads and reloads, scene packs included
+		TexturePackingDesc TexturePacking;
+
+		// Applies to models uploaded by subsequent loads and reloads; see CreateModel
+		bool IsVertexCompressionEnabled{};
+
+		// Applies to models decoded by subsequent loads and reloads; LODs are only generated and uploaded when LOD.IsEnabled, which enables LODSelection
+		MeshOptimizationDesc MeshOptimization;
+
+		/*
+		 * Read by CreateAccelerationStructures, which picks for each instance the coarsest LOD whose error projects to at most MaxPixelError pixels,
+		 * and by RequestTextureMips.
+		 */
+		struct {
+			float MaxPixelError = 1;
+
+			XMFLOAT3 ViewPosition{};
+
+			// Pixels covered by a unit length at unit distance
+			float PixelsPerUnit{};
+		} LODSelection;
+
 		explicit Scene(const DeviceContext& deviceContext) : m_deviceContext(deviceContext), m_skeletalMeshSkinning(deviceContext) {}
 
 		~Scene() override {
@@ -112,11 +182,15 @@ export {
 				IDs.emplace_back(ID.first);
 				MeshNode->OnDestroyed.remove(ID.second);
 			}
+			for (const auto& LODIDs : m_LODBottomLevelAccelerationStructureIDs | views::values) {
+				ranges::copy_if(LODIDs, back_inserter(IDs), [](uint64_t ID) { return ID != ~0ull; });
+			}
 			if (m_topLevelAccelerationStructure.ID != ~0ull) {
 				IDs.emplace_back(m_topLevelAccelerationStructure.ID);
 			}
 			m_deviceContext.AccelerationStructureManager->RemoveAccelerationStructures(IDs);
 			m_bottomLevelAccelerationStructureIDs = {};
+			m_LODBottomLevelAccelerationStructureIDs = {};
 			m_topLevelAccelerationStructure = {};
 
 			CollectGarbage();
@@ -126,51 +200,220 @@ export {
 
 		virtual void Tick(double elapsedSeconds, const GamePad::ButtonStateTracker& gamepadStateTracker, const Keyboard::KeyboardStateTracker& keyboardStateTracker, const Mouse::ButtonStateTracker& mouseStateTracker) = 0;
 
-		void Load(const SceneDesc& sceneDesc) {
+		struct LoadStatistics {
+			struct Stage {
+				size_t ItemCount{}, ByteCount{};
+				steady_clock::duration BusyTime{};
+			};
+			// Decode time is summed over all workers
+			Stage Decode, Upload, Animation;
+			size_t DecodeWorkerCount{};
+
+			// Models and animation collections taken from the resident asset cache
+			size_t ResidentItemCount{};
+
+			// Until the first model can be rendered
+			steady_clock::duration FirstModelTime{};
+
+			steady_clock::duration TotalTime{};
+		};
+
+		/*
+		 * In progressive mode the scene becomes ready as soon as the environment light is loaded,
+		 * models are loaded closest to the camera first, and their render objects are handed over through
+		 * CommitLoadedRenderObjects, which the render thread calls every frame.
+		 * Assets found in residentAssetCache are reused as is, and newly loaded ones are added to it.
+		 * Model textures of this load and later reloads are streamed through textureStreamer when set.
+		 */
+		void Load(
+			const SceneDesc& sceneDesc, bool isProgressive = false, ResidentAssetCache* residentAssetCache = nullptr,
+			TextureStreamer* textureStreamer = nullptr
+		) {
+			const auto startTime = steady_clock::now();
+
+			m_loadStatistics = {};
+
+			m_textureStreamer = textureStreamer;
+
 			reinterpret_cast<SceneBase&>(*this) = sceneDesc;
 
+			const auto scenePack = sceneDesc.ScenePack.get();
+
+			const auto GetResidentKey = [&](const path& filePath) {
+				return residentAssetCache != nullptr ? ResidentAssetCache::GetKey(ResolveResourcePath(filePath), scenePack) : wstring();
+			};
+
 			CommandList commandList(m_deviceContext);
 			commandList.Begin();
 
 			reinterpret_cast<EnvironmentLightBase&>(EnvironmentLight) = sceneDesc.EnvironmentLight;
-			if (!empty(sceneDesc.EnvironmentLight.Texture)) {
-				EnvironmentLight.Texture = LoadTexture(commandList, ResolveResourcePath(sceneDesc.EnvironmentLight.Texture), true);
-				EnvironmentLight.Texture->CreateSRV();
+			if (const auto& filePath = sceneDesc.EnvironmentLight.Texture; !empty(filePath)) {
+				const auto key = GetResidentKey(filePath);
+				if (residentAssetCache != nullptr) {
+					EnvironmentLight.Texture = residentAssetCache->Find<Texture>(key);
+				}
+
+				if (!EnvironmentLight.Texture) {
+					if (scenePack != nullptr) {
+						ScratchImage image;
+						scenePack->ReadImage(image, filePath);
+						EnvironmentLight.Texture = LoadTexture(commandList, image);
+					}
+					else {
+						EnvironmentLight.Texture = LoadEnvironmentLightTexture(commandList, ResolveResourcePath(filePath));
+					}
+					EnvironmentLight.Texture->CreateSRV();
+
+					if (residentAssetCache != nullptr) {
+						residentAssetCache->Add(key, EnvironmentLight.Texture);
+					}
+				}
 			}
 
-			{
-				unordered_map<string, path> modelDescs, animationDescs;
-				for (const auto renderObject : sceneDesc.RenderObjects) {
-					if (!empty(renderObject.Model)) {
-						modelDescs.try_emplace(renderObject.Model, sceneDesc.Models.at(renderObject.Model));
+			unordered_map<string, path> modelDescs, animationDescs;
+			unordered_map<string, float> modelPriorities;
+			unordered_map<string, vector<const RenderObjectDesc*>> modelRenderObjectDescs;
+			for (const auto& renderObject : sceneDesc.RenderObjects) {
+				if (!empty(renderObject.Model)) {
+					modelDescs.try_emplace(renderObject.Model, sceneDesc.Models.at(renderObject.Model));
+
+					const auto distance = Vector3::DistanceSquared(renderObject.Transform.Translation, sceneDesc.Camera.Position);
+					if (const auto [first, second] = modelPriorities.try_emplace(renderObject.Model, distance); !second) {
+						first->second = min(first->second, distance);
+					}
+
+					modelRenderObjectDescs[renderObject.Model].emplace_back(&renderObject);
+				}
+
+				if (!empty(renderObject.Animation)) {
+					animationDescs.try_emplace(renderObject.Animation, sceneDesc.Animations.at(renderObject.Animation));
+				}
+			}
+
+			m_files = GetFiles(sceneDesc, modelDescs, animationDescs);
+
+			vector<string> residentModelKeys;
+			if (residentAssetCache != nullptr) {
+				for (const auto& [Key, FilePath] : modelDescs) {
+					if (auto model = residentAssetCache->Find<Model>(GetResidentKey(FilePath))) {
+						Models[Key] = move(model);
+						residentModelKeys.emplace_back(Key);
 					}
+				}
 
-					if (!empty(renderObject.Animation)) {
-						animationDescs.try_emplace(renderObject.Animation, sceneDesc.Animations.at(renderObject.Animation));
+				for (const auto& [Key, FilePath] : animationDescs) {
+					if (auto animationCollection = residentAssetCache->Find<AnimationCollection>(GetResidentKey(FilePath))) {
+						AnimationCollections[Key] = move(animationCollection);
+						m_loadStatistics.ResidentItemCount++;
 					}
 				}
 
-				Models.Load(modelDescs, true, 8, m_deviceContext);
+				m_loadStatistics.ResidentItemCount += size(residentModelKeys);
+			}
+
+			if (isProgressive) {
+				// An empty TLAS lets the scene be rendered before any model has arrived
+				CreateAccelerationStructures(commandList);
 
-				AnimationCollections.Load(animationDescs, true, 8);
+				commandList.End();
+
+				commandList.Begin();
 
+				vector<LoadedRenderObject> renderObjects;
 				for (const auto& renderObjectDesc : sceneDesc.RenderObjects) {
-					RenderObject renderObject;
-					reinterpret_cast<RenderObjectBase&>(renderObject) = renderObjectDesc;
+					if (empty(renderObjectDesc.Model)) {
+						renderObjects.emplace_back(renderObjectDesc, CreateRenderObject(renderObjectDesc, commandList));
+					}
+				}
+				AddLoadedRenderObjects(move(renderObjects));
+
+				m_isReady = true;
+			}
+
+			{
+				// Files referenced by both Models and Animations are parsed only once
+				GLTFHelpers::AssetCache assetCache;
+
+				auto& threadPool = ThreadPool::GetDefault();
+
+				// Animations do not touch the GPU, so they load alongside the model pipeline
+				const auto animationFuture = threadPool.Submit([&] {
+					const auto animationStartTime = steady_clock::now();
+
+					AnimationCollections.Load(animationDescs, true, assetCache, scenePack);
+
+					if (residentAssetCache != nullptr) {
+						for (const auto& [Key, FilePath] : animationDescs) {
+							residentAssetCache->Add(GetResidentKey(FilePath), AnimationCollections.at(Key));
+						}
+					}
+
+					auto& statistics = m_loadStatistics.Animation;
+					statistics.ItemCount = size(animationDescs);
+					statistics.BusyTime = steady_clock::now() - animationStartTime;
+				}).share();
+
+				const auto OnModelLoaded = [&](const vector<string>& keys) {
+					vector<LoadedRenderObject> renderObjects;
+					for (const auto& key : keys) {
+						for (const auto renderObjectDesc : modelRenderObjectDescs.at(key)) {
+							if (!empty(renderObjectDesc->Animation)) {
+								threadPool.Wait(animationFuture);
+								animationFuture.get();
+							}
+
+							renderObjects.emplace_back(*renderObjectDesc, CreateRenderObject(*renderObjectDesc, commandList));
+						}
+					}
+
+					// Copies of skinned buffers must have landed before the render thread can see them
+					commandList.End();
 
-					if (!empty(renderObjectDesc.Model)) {
-						renderObject.Model = Model(*Models.at(renderObjectDesc.Model), commandList);
+					commandList.Begin();
+
+					if (m_loadStatistics.FirstModelTime == steady_clock::duration()) {
+						m_loadStatistics.FirstModelTime = steady_clock::now() - startTime;
 					}
 
-					if (!empty(renderObjectDesc.Animation)) {
-						renderObject.AnimationCollection = *AnimationCollections.at(renderObjectDesc.Animation);
-						renderObject.AnimationCollection.Bind(renderObject.Model.SkinJoints);
+					AddLoadedRenderObjects(move(renderObjects));
+				};
+
+				try {
+					if (isProgressive && !empty(residentModelKeys)) {
+						OnModelLoaded(residentModelKeys);
 					}
 
-					RenderObjects.emplace_back(renderObject);
+					LoadModels(
+						Models, modelDescs, modelPriorities, assetCache, scenePack, residentAssetCache, commandList,
+						isProgressive ? function<void(const vector<string>&)>(OnModelLoaded) : nullptr
+					);
 				}
+				catch (...) {
+					// The animation task references the asset cache and the descs
+					threadPool.Wait(animationFuture);
+
+					throw;
+				}
+
+				threadPool.Wait(animationFuture);
+				animationFuture.get();
+			}
+
+			if (isProgressive) {
+				commandList.End();
+
+				m_loadStatistics.TotalTime = steady_clock::now() - startTime;
+
+				return;
 			}
 
+			for (const auto& renderObjectDesc : sceneDesc.RenderObjects) {
+				RenderObjects.emplace_back(CreateRenderObject(renderObjectDesc, commandList));
+
+				m_isAnimated |= !empty(renderObjectDesc.Animation);
+			}
+			m_renderObjectDescs = sceneDesc.RenderObjects;
+
 			Tick(0);
 
 			Refresh();
@@ -186,10 +429,214 @@ export {
 			commandList.CompactAccelerationStructures();
 
 			commandList.End();
+
+			m_loadStatistics.TotalTime = m_loadStatistics.FirstModelTime = steady_clock::now() - startTime;
+
+			m_isReady = true;
+		}
+
+		bool IsReady() const noexcept { return m_isReady; }
+
+		bool IsAnimated() const noexcept { return m_isAnimated; }
+
+		// Moves render objects that a progressive load has finished into RenderObjects; returns whether there were any
+		bool CommitLoadedRenderObjects(CommandList& commandList) {
+			vector<LoadedRenderObject> renderObjects;
+			{
+				const scoped_lock lock(m_loadedRenderObjectMutex);
+
+				renderObjects = exchange(m_loadedRenderObjects, {});
+			}
+			if (empty(renderObjects)) {
+				return false;
+			}
+
+			for (auto& [RenderObjectDesc, RenderObject] : renderObjects) {
+				m_isAnimated |= !empty(RenderObject.AnimationCollection);
+
+				RenderObjects.emplace_back(move(RenderObject));
+				m_renderObjectDescs.emplace_back(move(RenderObjectDesc));
+			}
+
+			Tick(0);
+
+			Refresh();
+
+			SkinSkeletalMeshes(commandList);
+
+			CreateAccelerationStructures(commandList);
+
+			return true;
+		}
+
+		// Whether a model, animation or environment light file has been written to since it was loaded; always false for scene packs
+		bool HasModifiedFiles() const {
+			return ranges::any_of(m_files.WriteTimes, [](const auto& value) { return GetLastWriteTime(value.first) != value.second; });
 		}
 
+		/*
+		 * Hot reload of a fully loaded scene. PrepareReload runs off the render thread: it loads only the models and animations
+		 * that are new or whose files have changed, and creates only the render objects that use them or whose keys changed.
+		 * CommitReload then patches RenderObjects on the render thread; every other render object is kept together with its BLASes
+		 * and textures, and only gets its name, transform and visibility updated.
+		 * Render objects are matched by name, and by order among render objects with the same name.
+		 * Nothing of the scene changes before CommitReload, so that a failed reload leaves it as it was.
+		 */
+		void PrepareReload(const SceneDesc& sceneDesc, ResidentAssetCache* residentAssetCache = nullptr) {
+			if (sceneDesc.ScenePack) {
+				throw invalid_argument("Scene packs cannot be hot reloaded");
+			}
+
+			auto reload = make_unique<Reload>();
+
+			CommandList commandList(m_deviceContext);
+			commandList.Begin();
+
+			reinterpret_cast<EnvironmentLightBase&>(reload->EnvironmentLight) = sceneDesc.EnvironmentLight;
+			if (const auto& filePath = sceneDesc.EnvironmentLight.Texture; !empty(filePath)) {
+				if (filePath == m_files.EnvironmentLightFilePath && !IsModified(ResolveResourcePath(filePath))) {
+					reload->EnvironmentLight.Texture = EnvironmentLight.Texture;
+				}
+				else {
+					reload->EnvironmentLight.Texture = LoadEnvironmentLightTexture(commandList, ResolveResourcePath(filePath));
+					reload->EnvironmentLight.Texture->CreateSRV();
+				}
+			}
+
+			unordered_map<string, path> modelDescs, animationDescs;
+			for (const auto& renderObject : sceneDesc.RenderObjects) {
+				if (!empty(renderObject.Model)) {
+					modelDescs.try_emplace(renderObject.Model, sceneDesc.Models.at(renderObject.Model));
+				}
+
+				if (!empty(renderObject.Animation)) {
+					animationDescs.try_emplace(renderObject.Animation, sceneDesc.Animations.at(renderObject.Animation));
+				}
+			}
+
+			// The dictionaries of the reload take the entries that are still used and unchanged, and changed ones are loaded into them,
+			// so that the scene keeps its own dictionaries untouched until CommitReload, whatever happens in between
+			const auto FindChangedKeys = [&](const auto& resources, auto& reloadedResources, const unordered_map<string, path>& descs, const unordered_map<string, path>& filePaths) {
+				unordered_map<string, path> changedDescs;
+				for (const auto& [Key, FilePath] : descs) {
+					const auto pResource = resources.find(Key);
+					if (const auto pFilePath = filePaths.find(Key);
+						pResource == cend(resources) || pFilePath == cend(filePaths) || pFilePath->second != FilePath || IsModified(ResolveResourcePath(FilePath))) {
+						changedDescs.emplace(Key, FilePath);
+					}
+					else {
+						reloadedResources.emplace(Key, pResource->second);
+					}
+				}
+				return changedDescs;
+			};
+			const auto changedModelDescs = FindChangedKeys(Models, reload->Models, modelDescs, m_files.ModelFilePaths);
+			const auto changedAnimationDescs = FindChangedKeys(AnimationCollections, reload->AnimationCollections, animationDescs, m_files.AnimationFilePaths);
+
+			reload->Files = GetFiles(sceneDesc, modelDescs, animationDescs);
+
+			{
+				GLTFHelpers::AssetCache assetCache;
+
+				reload->AnimationCollections.Load(changedAnimationDescs, true, assetCache, nullptr);
+
+				if (residentAssetCache != nullptr) {
+					for (const auto& [Key, FilePath] : changedAnimationDescs) {
+						residentAssetCache->Add(ResidentAssetCache::GetKey(ResolveResourcePath(FilePath), nullptr), reload->AnimationCollections.at(Key));
+					}
+				}
+
+				// BLASes are left to CommitReload, as the acceleration structure manager belongs to the render thread
+				unordered_map<string, float> priorities;
+				for (const auto& key : changedModelDescs | views::keys) {
+					priorities.emplace(key, 0.0f);
+				}
+				LoadModels(reload->Models, changedModelDescs, priorities, assetCache, nullptr, residentAssetCache, commandList, [](const vector<string>&) {});
+			}
+
+			map<pair<string, size_t>, size_t> previousIndices;
+			{
+				unordered_map<string, size_t> nameCounts;
+				for (size_t i = 0; const auto& renderObjectDesc : m_renderObjectDescs) {
+					previousIndices.emplace(pair(renderObjectDesc.Name, nameCounts[renderObjectDesc.Name]++), i++);
+				}
+			}
+
+			unordered_map<string, size_t> nameCounts;
+			reload->RenderObjects.reserve(size(sceneDesc.RenderObjects));
+			for (const auto& renderObjectDesc : sceneDesc.RenderObjects) {
+				auto& renderObject = reload->RenderObjects.emplace_back(ReloadedRenderObject{ .Desc = renderObjectDesc });
+
+				if (const auto pPreviousIndex = previousIndices.find(pair(renderObjectDesc.Name, nameCounts[renderObjectDesc.Name]++));
+					pPreviousIndex != cend(previousIndices)) {
+					if (const auto& previousDesc = m_renderObjectDescs[pPreviousIndex->second];
+						previousDesc.Model == renderObjectDesc.Model && previousDesc.Animation == renderObjectDesc.Animation
+						&& !changedModelDescs.contains(renderObjectDesc.Model) && !changedAnimationDescs.contains(renderObjectDesc.Animation)) {
+						renderObject.PreviousIndex = pPreviousIndex->second;
+						continue;
+					}
+				}
+
+				renderObject.RenderObject = CreateRenderObject(renderObjectDesc, commandList, reload.get());
+			}
+
+			commandList.End();
+
+			m_reload = move(reload);
+		}
+
+		// Applies what PrepareReload has prepared, if anything; returns whether the scene has changed
+		bool CommitReload(CommandList& commandList) {
+			if (!m_reload) {
+				return false;
+			}
+
+			const auto reload = move(m_reload);
+
+			vector<RenderObject> renderObjects;
+			vector<RenderObjectDesc> renderObjectDescs;
+			renderObjects.reserve(size(reload->RenderObjects));
+			renderObjectDescs.reserve(size(reload->RenderObjects));
+			m_isAnimated = false;
+			for (auto& [Desc, PreviousIndex, RenderObject] : reload->RenderObjects) {
+				auto& renderObject = renderObjects.emplace_back(PreviousIndex == ~0ull ? move(RenderObject) : move(RenderObjects[PreviousIndex]));
+				reinterpret_cast<RenderObjectBase&>(renderObject) = Desc;
+
+				m_isAnimated |= !empty(renderObject.AnimationCollection);
+
+				renderObjectDescs.emplace_back(move(Desc));
+			}
+
+			// Render objects that are gone release their mesh nodes here, which queues their BLASes for CollectGarbage
+			RenderObjects = move(renderObjects);
+			m_renderObjectDescs = move(renderObjectDescs);
+
+			// Entries that are no longer used are dropped along with the previous dictionaries
+			Models = move(reload->Models);
+			AnimationCollections = move(reload->AnimationCollections);
+
+			EnvironmentLight = move(reload->EnvironmentLight);
+
+			m_files = move(reload->Files);
+
+			Tick(0);
+
+			Refresh();
+
+			SkinSkeletalMeshes(commandList);
+
+			CreateAccelerationStructures(commandList);
+
+			return true;
+		}
+
+		const auto& GetLoadStatistics() const noexcept { return m_loadStatistics; }
+
 		const auto& GetInstanceData() const noexcept { return m_instanceData; }
 
+		// Levels that instances may select, each with its own objects after the first; 1 unless models are loaded with LODs
+		uint32_t GetLODCount(const MeshNode& meshNode) const { return MeshOptimization.LOD.IsEnabled ? meshNode.GetLODCount() : 1; }
+
 		auto GetObjectCount() const noexcept { return m_objectCount; }
 
 		void Refresh() {
@@ -224,9 +671,12 @@ export {
 						m_instanceData.emplace_back(instanceData);
 					}
 					instanceIndex++;
-					objectIndex += static_cast<uint32_t>(size(meshNode->Meshes));
+					// Every LOD has its own objects, which instances select through their ID
+					objectIndex += static_cast<uint32_t>(size(meshNode->Meshes)) * GetLODCount(*meshNode);
 				}
 			}
+			// Render objects may have been removed by a hot reload
+			m_instanceData.resize(instanceIndex);
 			m_objectCount = objectIndex;
 		}
 
@@ -273,7 +723,7 @@ export {
 							.MotionVectors = mesh->MotionVectors.get()
 						};
 
-						m_skeletalMeshSkinning.Process(commandList);
+						m_skeletalMeshSkinning.Process(commandList, mesh->GetSkinDesc());
 					}
 				}
 			}
@@ -314,15 +764,7 @@ export {
 							continue;
 						}
 
-						auto& _geometryDescs = geometryDescs.emplace_back();
-						_geometryDescs.reserve(size(meshNode->Meshes));
-						for (const auto& mesh : meshNode->Meshes) {
-							_geometryDescs.emplace_back(CreateGeometryDesc(
-								*mesh->Vertices, *mesh->Indices,
-								mesh->MaterialIndex == ~0u || model.Materials[mesh->MaterialIndex].AlphaMode == AlphaMode::Opaque ?
-								D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE : D3D12_RAYTRACING_GEOMETRY_FLAG_NONE
-							));
-						}
+						const auto& _geometryDescs = geometryDescs.emplace_back(CreateGeometryDescs(model, *meshNode));
 
 						if (const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs{
 							.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
@@ -345,15 +787,7 @@ export {
 					const auto IDs = commandList.BuildAccelerationStructures(newInputs);
 
 					for (size_t i = 0; const auto & meshNode : newMeshNodes) {
-						auto& ID = m_bottomLevelAccelerationStructureIDs.at(meshNode);
-						ID.first = IDs[i++];
-						ID.second = meshNode->OnDestroyed.append([&](MeshNode* pMeshNode) {
-							if (const auto pID = m_bottomLevelAccelerationStructureIDs.find(pMeshNode);
-							pID != cend(m_bottomLevelAccelerationStructureIDs)) {
-							m_unreferencedBottomLevelAccelerationStructureIDs.emplace_back(pID->second.first);
-							m_bottomLevelAccelerationStructureIDs.erase(pID);
-						}
-							});
+						RegisterBottomLevelAccelerationStructure(*meshNode, IDs[i++]);
 					}
 				}
 
@@ -362,16 +796,61 @@ export {
 				}
 			}
 
+			// BLASes of coarser LODs are built the first time an instance selects them
+			vector<uint32_t> LODIndices;
+			LODIndices.reserve(size(m_instanceData));
+			{
+				vector<vector<D3D12_RAYTRACING_GEOMETRY_DESC>> geometryDescs;
+				vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> inputs;
+				vector<pair<MeshNode*, uint32_t>> newLODs;
+
+				for (uint32_t instanceIndex = 0; const auto & renderObject : RenderObjects) {
+					for (const auto& meshNode : renderObject.Model.MeshNodes) {
+						const auto LODIndex = SelectLOD(renderObject.Model, *meshNode, m_instanceData[instanceIndex++].ObjectToWorld);
+						LODIndices.emplace_back(LODIndex);
+						if (!LODIndex) {
+							continue;
+						}
+
+						auto& IDs = m_LODBottomLevelAccelerationStructureIDs[meshNode.get()];
+						IDs.resize(meshNode->GetLODCount() - 1, ~0ull);
+						if (const pair newLOD(meshNode.get(), LODIndex); IDs[LODIndex - 1] == ~0ull && !ranges::contains(newLODs, newLOD)) {
+							const auto& _geometryDescs = geometryDescs.emplace_back(CreateGeometryDescs(renderObject.Model, *meshNode, LODIndex));
+							inputs.emplace_back(D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS{
+								.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
+								.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION,
+								.NumDescs = static_cast<UINT>(size(_geometryDescs)),
+								.pGeometryDescs = data(_geometryDescs)
+								});
+							newLODs.emplace_back(newLOD);
+						}
+					}
+				}
+
+				if (!empty(inputs)) {
+					const auto IDs = commandList.BuildAccelerationStructures(inputs);
+					for (size_t i = 0; const auto & [MeshNode, LODIndex] : newLODs) {
+						m_LODBottomLevelAccelerationStructureIDs.at(MeshNode)[LODIndex - 1] = IDs[i++];
+					}
+				}
+			}
+
 			vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
 			instanceDescs.reserve(size(m_instanceData));
 			for (uint32_t instanceIndex = 0; const auto & renderObject : RenderObjects) {
 				for (const auto& meshNode : renderObject.Model.MeshNodes) {
+					const auto LODIndex = LODIndices[instanceIndex];
 					const auto& instanceData = m_instanceData[instanceIndex++];
+					const auto objectIndex = instanceData.FirstGeometryIndex + LODIndex * static_cast<uint32_t>(size(meshNode->Meshes));
 					auto& instanceDesc = instanceDescs.emplace_back(D3D12_RAYTRACING_INSTANCE_DESC{
-						.InstanceID = instanceData.FirstGeometryIndex,
+						.InstanceID = objectIndex,
 						.InstanceMask = renderObject.IsVisible ? ~0u : 0,
-						.InstanceContributionToHitGroupIndex = instanceData.FirstGeometryIndex,
-						.AccelerationStructure = accelerationStructureManager.GetAccelStructGPUVA(m_bottomLevelAccelerationStructureIDs.at(meshNode.get()).first)
+						.InstanceContributionToHitGroupIndex = objectIndex,
+						.AccelerationStructure = accelerationStructureManager.GetAccelStructGPUVA(
+							LODIndex ?
+							m_LODBottomLevelAccelerationStructureIDs.at(meshNode.get())[LODIndex - 1] :
+							m_bottomLevelAccelerationStructureIDs.at(meshNode.get()).first
+						)
 						});
 					reinterpret_cast<XMFLOAT3X4&>(instanceDesc.Transform) = instanceData.ObjectToWorld;
 				}
@@ -379,6 +858,37 @@ export {
 			BuildTopLevelAccelerationStructure(commandList, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE, instanceDescs, false, m_topLevelAccelerationStructure);
 		}
 
+		/*
+		 * Asks the texture streamer for the mips that each mesh needs as seen from LODSelection.ViewPosition,
+		 * assuming that its textures span its bounding sphere once; meshes around the view ask for their most detailed mips.
+		 */
+		void RequestTextureMips() const {
+			if (m_textureStreamer == nullptr) {
+				return;
+			}
+
+			for (uint32_t instanceIndex = 0; const auto & renderObject : RenderObjects) {
+				for (const auto& meshNode : renderObject.Model.MeshNodes) {
+					const auto transform = XMLoadFloat3x4(&m_instanceData[instanceIndex++].ObjectToWorld);
+					for (const auto& mesh : meshNode->Meshes) {
+						if (mesh->TextureIndex == ~0u) {
+							continue;
+						}
+
+						BoundingSphere bounds;
+						mesh->Bounds.Transform(bounds, transform);
+						const auto distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Center) - XMLoadFloat3(&LODSelection.ViewPosition))) - bounds.Radius;
+						const auto screenSize = distance > 0 ? 2 * bounds.Radius * LODSelection.PixelsPerUnit / distance : FLT_MAX;
+						for (const auto& [Texture, _1, _2] : renderObject.Model.Textures[mesh->TextureIndex]) {
+							if (Texture) {
+								m_textureStreamer->RequestMip(*Texture, screenSize);
+							}
+						}
+					}
+				}
+			}
+		}
+
 		void CollectGarbage() {
 			if (!empty(m_unreferencedBottomLevelAccelerationStructureIDs)) {
 				m_deviceContext.AccelerationStructureManager->RemoveAccelerationStructures(m_unreferencedBottomLevelAccelerationStructureIDs);
@@ -392,6 +902,128 @@ export {
 	private:
 		const DeviceContext& m_deviceContext;
 
+		LoadStatistics m_loadStatistics;
+
+		TextureStreamer* m_textureStreamer{};
+
+		atomic_bool m_isReady{};
+		bool m_isAnimated{};
+
+		mutex m_loadedRenderObjectMutex;
+		using LoadedRenderObject = pair<RenderObjectDesc, RenderObject>;
+		vector<LoadedRenderObject> m_loadedRenderObjects;
+
+		// Descriptions of RenderObjects, in the same order, for hot reload
+		vector<RenderObjectDesc> m_renderObjectDescs;
+
+		// Files the loaded scene was read from, as described and with their write times, for hot reload
+		struct Files {
+			unordered_map<path, file_time_type> WriteTimes;
+			unordered_map<string, path> ModelFilePaths, AnimationFilePaths;
+			path EnvironmentLightFilePath;
+		} m_files;
+
+		struct ReloadedRenderObject {
+			RenderObjectDesc Desc;
+
+			// Index into RenderObjects of the render object to keep, or ~0ull to use RenderObject
+			size_t PreviousIndex = ~0ull;
+			RenderObject RenderObject;
+		};
+		struct Reload {
+			decltype(Scene::EnvironmentLight) EnvironmentLight;
+			decltype(Scene::Models) Models;
+			decltype(Scene::AnimationCollections) AnimationCollections;
+			vector<ReloadedRenderObject> RenderObjects;
+			Scene::Files Files;
+		};
+		unique_ptr<Reload> m_reload;
+
+		bool IsModified(const path& filePath) const {
+			const auto pWriteTime = m_files.WriteTimes.find(filePath);
+			return pWriteTime == cend(m_files.WriteTimes) || pWriteTime->second != GetLastWriteTime(filePath);
+		}
+
+		// Write times are taken before loading, so that files written meanwhile are picked up by the next reload; scene packs have none
+		static Files GetFiles(const SceneDesc& sceneDesc, const unordered_map<string, path>& modelDescs, const unordered_map<string, path>& animationDescs) {
+			Files files;
+			if (sceneDesc.ScenePack) {
+				return files;
+			}
+
+			for (const auto descs : { &modelDescs, &animationDescs }) {
+				for (const auto& filePath : *descs | views::values) {
+					const auto resolvedPath = ResolveResourcePath(filePath);
+					files.WriteTimes[resolvedPath] = GetLastWriteTime(resolvedPath);
+				}
+			}
+			if (const auto& filePath = sceneDesc.EnvironmentLight.Texture; !empty(filePath)) {
+				const auto resolvedPath = ResolveResourcePath(filePath);
+				files.WriteTimes[resolvedPath] = GetLastWriteTime(resolvedPath);
+			}
+			files.ModelFilePaths = modelDescs;
+			files.AnimationFilePaths = animationDescs;
+			files.EnvironmentLightFilePath = sceneDesc.EnvironmentLight.Texture;
+			return files;
+		}
+
+		// Scene packs are cooked with LODs, which are only uploaded when they are selected
+		static void ReadModel(const ScenePackReader& scenePack, ModelData& modelData, const path& filePath, const MeshOptimizationDesc& meshOptimization) {
+			scenePack.ReadModel(modelData, filePath);
+			if (!meshOptimization.LOD.IsEnabled) {
+				for (auto& meshNode : modelData.MeshNodes) {
+					for (auto& mesh : meshNode.Meshes) {
+						mesh.LODs = {};
+					}
+				}
+			}
+		}
+
+		// Given a mip chain and compressed like imported textures, to BC6H for HDR images
+		unique_ptr<Texture> LoadEnvironmentLightTexture(CommandList& commandList, const path& filePath) const {
+			constexpr auto Format = DXGI_FORMAT_BC7_UNORM;
+			const auto Decode = [&](ScratchImage& decodedImage) {
+				DecodeTexture(decodedImage, filePath, true);
+				GenerateMipChain(decodedImage);
+				if (TextureCompression.IsEnabled) {
+					CompressTexture(decodedImage, Format, TEX_COMPRESS_BC7_QUICK);
+				}
+			};
+
+			ScratchImage image;
+			if (TextureCompression.IsEnabled) {
+				const auto textureKey = GetTextureKey(MemoryMappedFile(filePath).GetData(), (static_cast<uint64_t>(Format) << 1) | true);
+				LoadCachedTexture(image, textureKey, TextureCompression.CacheDirectoryPath, Decode);
+			}
+			else {
+				Decode(image);
+			}
+			return LoadTexture(commandList, image);
+		}
+
+		// Models and animations come from the dictionaries of reload when set
+		RenderObject CreateRenderObject(const RenderObjectDesc& renderObjectDesc, CommandList& commandList, const Reload* reload = nullptr) {
+			RenderObject renderObject;
+			reinterpret_cast<RenderObjectBase&>(renderObject) = renderObjectDesc;
+
+			if (!empty(renderObjectDesc.Model)) {
+				renderObject.Model = Model(*(reload != nullptr ? reload->Models : Models).at(renderObjectDesc.Model), commandList);
+			}
+
+			if (!empty(renderObjectDesc.Animation)) {
+				renderObject.AnimationCollection = *(reload != nullptr ? reload->AnimationCollections : AnimationCollections).at(renderObjectDesc.Animation);
+				renderObject.AnimationCollection.Bind(renderObject.Model.SkinJoints);
+			}
+
+			return renderObject;
+		}
+
+		void AddLoadedRenderObjects(vector<LoadedRenderObject>&& renderObjects) {
+			const scoped_lock lock(m_loadedRenderObjectMutex);
+
+			m_loadedRenderObjects.append_range(move(renderObjects));
+		}
+
 		SkeletalMeshSkinning m_skeletalMeshSkinning;
 
 		vector<InstanceData> m_instanceData;
@@ -399,6 +1031,262 @@ export {
 
 		vector<uint64_t> m_unreferencedBottomLevelAccelerationStructureIDs;
 		unordered_map<MeshNode*, pair<uint64_t, MeshNode::DestroyEvent::Handle>> m_bottomLevelAccelerationStructureIDs;
+		// Per LOD from 1, ~0ull for the ones not built yet; released along with the entry above
+		unordered_map<MeshNode*, vector<uint64_t>> m_LODBottomLevelAccelerationStructureIDs;
 		TopLevelAccelerationStructure m_topLevelAccelerationStructure;
+
+		/*
+		 * Models go through two overlapping stages:
+		 * tasks on the shared thread pool parse and decode files into ModelData, while this thread records uploads and static BLAS builds
+		 * for each decoded one, so that the GPU work of one model hides the CPU work of the next ones.
+		 * Files are decoded and uploaded in ascending order of priority, with a bounded number of them in flight, and keys that models already holds are skipped.
+		 * When onModelLoaded is set, it receives the keys of every uploaded model and BLASes are left to CreateAccelerationStructures,
+		 * as the acceleration structure manager then belongs to the render thread.
+		 */
+		void LoadModels(
+			decltype(Models)& models, const unordered_map<string, path>& descs, const unordered_map<string, float>& priorities,
+			GLTFHelpers::AssetCache& assetCache, const ScenePackReader* scenePack, ResidentAssetCache* residentAssetCache,
+			CommandList& commandList,
+			const function<void(const vector<string>&)>& onModelLoaded
+		) {
+			struct Job {
+				path FilePath;
+				vector<string> Keys;
+				float Priority;
+			};
+			vector<Job> jobs;
+			unordered_map<path, size_t> jobIndices;
+			for (const auto& [Key, FilePath] : descs) {
+				if (const auto pModel = models.find(Key); pModel != cend(models) && pModel->second) {
+					continue;
+				}
+
+				const auto filePath = ResolveResourcePath(FilePath);
+				const auto priority = priorities.at(Key);
+				if (const auto [first, second] = jobIndices.try_emplace(GetCanonicalPath(filePath), size(jobs)); second) {
+					jobs.emplace_back(filePath, vector{ Key }, priority);
+				}
+				else {
+					auto& job = jobs[first->second];
+					job.Keys.emplace_back(Key);
+					job.Priority = min(job.Priority, priority);
+				}
+			}
+			if (empty(jobs)) {
+				return;
+			}
+			ranges::sort(jobs, {}, &Job::Priority);
+
+			// Images with identical content are decoded and uploaded once, however many models ship them
+			GLTFHelpers::ImageCache imageCache(TextureCompression);
+			TextureCache textureCache(TexturePacking, m_textureStreamer);
+
+			auto& threadPool = ThreadPool::GetDefault();
+
+			const auto workerCount = min(size(jobs), threadPool.GetThreadCount());
+			m_loadStatistics.DecodeWorkerCount = workerCount;
+
+			mutex decodeMutex;
+			const auto Decode = [&](size_t jobIndex) {
+				const auto startTime = steady_clock::now();
+
+				ModelData modelData;
+				if (const auto& filePath = jobs[jobIndex].FilePath; scenePack != nullptr) {
+					ReadModel(*scenePack, modelData, filePath, MeshOptimization);
+				}
+				else {
+					GLTFHelpers::DecodeModel(modelData, *assetCache.Load(filePath), true, &imageCache, MeshOptimization);
+				}
+
+				{
+					const scoped_lock lock(decodeMutex);
+
+					auto& statistics = m_loadStatistics.Decode;
+					statistics.ItemCount++;
+					statistics.ByteCount += modelData.GetSize();
+					statistics.BusyTime += steady_clock::now() - startTime;
+				}
+
+				return modelData;
+			};
+
+			// Up to two decoded models wait for upload beside the ones being decoded
+			const auto maxDecodingCount = workerCount + 2;
+
+			deque<future<ModelData>> decodingModels;
+			size_t nextJobIndex = 0;
+			const auto SubmitDecodes = [&] {
+				for (; nextJobIndex < size(jobs) && size(decodingModels) < maxDecodingCount; nextJobIndex++) {
+					decodingModels.emplace_back(threadPool.Submit([&Decode, jobIndex = nextJobIndex] { return Decode(jobIndex); }));
+				}
+			};
+
+			try {
+				SubmitDecodes();
+
+				for (size_t jobIndex = 0; jobIndex < size(jobs); jobIndex++) {
+					// Decode tasks block on cache entries and file reads that other threads produce, never on anything this thread holds,
+					// so running them here while waiting is safe
+					threadPool.Wait(decodingModels.front());
+					const auto modelData = decodingModels.front().get();
+					decodingModels.pop_front();
+
+					SubmitDecodes();
+
+					const auto startTime = steady_clock::now();
+
+					const auto model = make_shared<Model>();
+					CreateModel(*model, modelData, commandList, &textureCache, IsVertexCompressionEnabled);
+
+					if (!onModelLoaded) {
+						BuildStaticBottomLevelAccelerationStructures(commandList, *model);
+					}
+
+					commandList.End();
+
+					textureCache.CommitStreamedTextures(commandList);
+
+					// Compaction sizes of the BLASes above are known once the command list has finished
+					commandList.Begin();
+					commandList.CompactAccelerationStructures();
+
+					const auto& job = jobs[jobIndex];
+					const auto& keys = job.Keys;
+					for (const auto& key : keys) {
+						models[key] = model;
+					}
+
+					if (residentAssetCache != nullptr) {
+						residentAssetCache->Add(ResidentAssetCache::GetKey(job.FilePath, scenePack), model);
+					}
+
+					if (onModelLoaded) {
+						onModelLoaded(keys);
+					}
+
+					auto& statistics = m_loadStatistics.Upload;
+					statistics.ItemCount++;
+					statistics.ByteCount += modelData.GetSize();
+					statistics.BusyTime += steady_clock::now() - startTime;
+				}
+			}
+			catch (...) {
+				// Tasks still in flight reference the locals of this function
+				for (const auto& future : decodingModels) {
+					threadPool.Wait(future);
+				}
+
+				throw;
+			}
+		}
+
+		static vector<D3D12_RAYTRACING_GEOMETRY_DESC> CreateGeometryDescs(const Model& model, const MeshNode& meshNode, uint32_t LODIndex = 0) {
+			vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs;
+			geometryDescs.reserve(size(meshNode.Meshes));
+			for (const auto& mesh : meshNode.Meshes) {
+				geometryDescs.emplace_back(CreateGeometryDesc(
+					*mesh->Vertices, *mesh->GetIndices(LODIndex),
+					mesh->MaterialIndex == ~0u || model.Materials[mesh->MaterialIndex].AlphaMode == AlphaMode::Opaque ?
+					D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE : D3D12_RAYTRACING_GEOMETRY_FLAG_NONE,
+					mesh->IsCompact ? (*mesh->PositionTransforms)->GetGPUVirtualAddress() + sizeof(XMFLOAT3X4) * mesh->PositionTransformIndex : NULL,
+					mesh->IsCompact ? DXGI_FORMAT_R16G16B16A16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT
+				));
+			}
+			return geometryDescs;
+		}
+
+		/*
+		 * Mesh nodes with skinning or emission stay at full detail: the former are rebuilt every frame,
+		 * and the latter are sampled as lights by the triangles of their full meshes.
+		 * The error of a level is the largest of its meshes, scaled by the largest stretch of the transform,
+		 * and projected at the nearest point of the bounds of the meshes, so that views from inside them keep full detail.
+		 */
+		uint32_t SelectLOD(const Model& model, const MeshNode& meshNode, const XMFLOAT3X4& objectToWorld) const {
+			const auto LODCount = GetLODCount(meshNode);
+			if (LODCount == 1 || meshNode.SkeletalTransforms) {
+				return 0;
+			}
+			for (const auto& mesh : meshNode.Meshes) {
+				if (mesh->SkeletalVertices) {
+					return 0;
+				}
+				if (mesh->MaterialIndex != ~0u) {
+					if (const auto& emissiveColor = model.Materials[mesh->MaterialIndex].EmissiveColor;
+						max({ emissiveColor.x, emissiveColor.y, emissiveColor.z }) > 0) {
+						return 0;
+					}
+				}
+			}
+
+			const auto transform = XMLoadFloat3x4(&objectToWorld);
+			const auto scale = XMVectorGetX(XMVectorMax(
+				XMVector3Length(transform.r[0]),
+				XMVectorMax(XMVector3Length(transform.r[1]), XMVector3Length(transform.r[2]))
+			));
+
+			auto distance = FLT_MAX;
+			for (const auto& mesh : meshNode.Meshes) {
+				BoundingSphere bounds;
+				mesh->Bounds.Transform(bounds, transform);
+				distance = min(distance, XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Center) - XMLoadFloat3(&LODSelection.ViewPosition))) - bounds.Radius);
+			}
+			if (distance <= 0) {
+				return 0;
+			}
+
+			const auto maxError = LODSelection.MaxPixelError * distance / (LODSelection.PixelsPerUnit * scale);
+			for (auto LODIndex = LODCount - 1; LODIndex; LODIndex--) {
+				if (ranges::all_of(meshNode.Meshes, [&](const auto& mesh) { return empty(mesh->LODs) || mesh->LODs[min<size_t>(LODIndex, size(mesh->LODs)) - 1].Error <= maxError; })) {
+					return LODIndex;
+				}
+			}
+			return 0;
+		}
+
+		void RegisterBottomLevelAccelerationStructure(MeshNode& meshNode, uint64_t ID) {
+			auto& _ID = m_bottomLevelAccelerationStructureIDs[&meshNode];
+			_ID.first = ID;
+			_ID.second = meshNode.OnDestroyed.append([&](MeshNode* pMeshNode) {
+				if (const auto pID = m_bottomLevelAccelerationStructureIDs.find(pMeshNode);
+				pID != cend(m_bottomLevelAccelerationStructureIDs)) {
+				m_unreferencedBottomLevelAccelerationStructureIDs.emplace_back(pID->second.first);
+				m_bottomLevelAccelerationStructureIDs.erase(pID);
+			}
+			if (const auto pIDs = m_LODBottomLevelAccelerationStructureIDs.find(pMeshNode);
+				pIDs != cend(m_LODBottomLevelAccelerationStructureIDs)) {
+				ranges::copy_if(pIDs->second, back_inserter(m_unreferencedBottomLevelAccelerationStructureIDs), [](uint64_t ID) { return ID != ~0ull; });
+				m_LODBottomLevelAccelerationStructureIDs.erase(pIDs);
+			}
+				});
+		}
+
+		// Mesh nodes without skinning are shared by every render object of the model, so their BLASes can be built right after upload
+		void BuildStaticBottomLevelAccelerationStructures(CommandList& commandList, const Model& model) {
+			vector<vector<D3D12_RAYTRACING_GEOMETRY_DESC>> geometryDescs;
+			vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> inputs;
+			vector<MeshNode*> meshNodes;
+			for (const auto& meshNode : model.MeshNodes) {
+				if (meshNode->SkeletalTransforms || ranges::any_of(meshNode->Meshes, [](const auto& mesh) { return mesh->SkeletalVertices != nullptr; })) {
+					continue;
+				}
+
+				const auto& _geometryDescs = geometryDescs.emplace_back(CreateGeometryDescs(model, *meshNode));
+				inputs.emplace_back(D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS{
+					.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
+					.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION,
+					.NumDescs = static_cast<UINT>(size(_geometryDescs)),
+					.pGeometryDescs = data(_geometryDescs)
+					});
+				meshNodes.emplace_back(meshNode.get());
+			}
+			if (empty(inputs)) {
+				return;
+			}
+
+			const auto IDs = commandList.BuildAccelerationStructures(inputs);
+			for (size_t i = 0; const auto meshNode : meshNodes) {
+				RegisterBottomLevelAccelerationStructure(*meshNode, IDs[i++]);
+			}
+		}
 	};
 }
@@ -0,0 +1,544 @@
+module;
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <span>
+
+#include <Windows.h>
+
+#include <compressapi.h>
+
+#include "directxtk12/SimpleMath.h"
+
+#include "DirectXTex.h"
+
+export module ScenePack;
+
+import Animation;
+import ErrorHelpers;
+import Material;
+import Math;
+import MemoryMappedFile;
+import Model;
+import ModelData;
+import TextureCompression;
+
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+using namespace DirectX::TextureHelpers;
+using namespace ErrorHelpers;
+using namespace Math;
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+	constexpr char g_magic[]{ 'S', 'P', 'A', 'K' };
+	constexpr uint32_t g_version = 2;
+
+	struct Header {
+		char Magic[size(g_magic)];
+		uint32_t Version;
+		uint64_t TableOfContentsOffset, TableOfContentsSize;
+	};
+
+	enum class ChunkType : uint32_t { Scene, Model, AnimationCollection, Image };
+
+	enum class ChunkCompression : uint32_t { None, XpressHuffman };
+
+	struct ChunkEntry {
+		ChunkType Type;
+		string Name;
+		ChunkCompression Compression;
+		uint64_t Offset, Size, UncompressedSize;
+	};
+
+	class BinaryWriter {
+	public:
+		template <typename T> requires is_trivially_copyable_v<T>
+		void Write(const T& value) { Write(span(&value, 1)); }
+
+		template <typename T> requires is_trivially_copyable_v<T>
+		void Write(span<const T> values) {
+			const auto bytes = as_bytes(values);
+			m_data.insert(cend(m_data), cbegin(bytes), cend(bytes));
+		}
+
+		void Write(string_view value) {
+			Write(static_cast<uint64_t>(size(value)));
+			Write(span(value));
+		}
+
+		template <typename T>
+		void WriteVector(const vector<T>& values) {
+			Write(static_cast<uint64_t>(size(values)));
+			Write(span<const T>(values));
+		}
+
+		auto& GetData() noexcept { return m_data; }
+
+	private:
+		vector<std::byte> m_data;
+	};
+
+	class BinaryReader {
+	public:
+		explicit BinaryReader(span<const std::byte> data) noexcept : m_data(data) {}
+
+		template <typename T> requires is_trivially_copyable_v<T>
+		T Read() {
+			T value;
+			Read(span(&value, 1));
+			return value;
+		}
+
+		template <typename T> requires is_trivially_copyable_v<T>
+		void Read(span<T> values) {
+			const auto bytes = as_writable_bytes(values);
+			ranges::copy(Consume(size(bytes)), data(bytes));
+		}
+
+		string ReadString() {
+			const auto bytes = Consume(Read<uint64_t>());
+			return { reinterpret_cast<const char*>(data(bytes)), size(bytes) };
+		}
+
+		template <typename T>
+		void ReadVector(vector<T>& values) {
+			const auto count = Read<uint64_t>();
+			if (count > (size(m_data) - m_offset) / sizeof(T)) {
+				Throw<runtime_error>("Scene pack chunk is truncated");
+			}
+			values.resize(count);
+			Read(span(values));
+		}
+
+	private:
+		span<const std::byte> m_data;
+		size_t m_offset{};
+
+		span<const std::byte> Consume(size_t size) {
+			if (size > ::size(m_data) - m_offset) {
+				Throw<runtime_error>("Scene pack chunk is truncated");
+			}
+			const auto bytes = m_data.subspan(m_offset, size);
+			m_offset += size;
+			return bytes;
+		}
+	};
+
+	void Write(BinaryWriter& writer, const vector<Animation::TargetNode>& targetNodes) {
+		writer.Write(static_cast<uint64_t>(size(targetNodes)));
+		for (const auto& [Name, Transform, Children] : targetNodes) {
+			writer.Write(Name);
+			writer.Write(Transform);
+			Write(writer, Children);
+		}
+	}
+
+	void Read(BinaryReader& reader, vector<Animation::TargetNode>& targetNodes) {
+		targetNodes.resize(reader.Read<uint64_t>());
+		for (auto& [Name, Transform, Children] : targetNodes) {
+			Name = reader.ReadString();
+			Transform = reader.Read<AffineTransform>();
+			Read(reader, Children);
+		}
+	}
+}
+
+export {
+	// Chunks are keyed by the path of their source relative to the scene, so the same key can be computed from either side
+	string GetScenePackChunkName(const path& filePath, const path& baseDirectory) {
+		const auto relativePath = filePath.lexically_relative(baseDirectory);
+		return (empty(relativePath) ? filePath : relativePath).lexically_normal().generic_string();
+	}
+
+	class ScenePackWriter {
+	public:
+		void AddSceneDesc(string_view json) {
+			AddChunk(ChunkType::Scene, "", as_bytes(span(json)));
+		}
+
+		void AddModel(string_view name, const ModelData& modelData) {
+			vector<string> imageNames;
+			imageNames.reserve(size(modelData.Images));
+			for (const auto& image : modelData.Images) {
+				imageNames.emplace_back(AddImage(*image.Image));
+			}
+
+			BinaryWriter writer;
+
+			writer.Write(modelData.Name);
+
+			writer.WriteVector(modelData.Materials);
+			writer.WriteVector(modelData.Textures);
+
+			writer.Write(static_cast<uint64_t>(size(modelData.Images)));
+			for (size_t i = 0; const auto & image : modelData.Images) {
+				writer.Write(image.TextureMapType);
+				writer.Write(imageNames[i++]);
+			}
+
+			writer.Write(static_cast<uint64_t>(size(modelData.Skins)));
+			for (const auto& skin : modelData.Skins) {
+				writer.Write(static_cast<uint64_t>(size(skin)));
+				for (const auto& [Name, InverseBindMatrix] : skin) {
+					writer.Write(Name);
+					writer.Write(InverseBindMatrix);
+				}
+			}
+
+			writer.Write(static_cast<uint64_t>(size(modelData.MeshNodes)));
+			for (const auto& meshNode : modelData.MeshNodes) {
+				writer.Write(meshNode.NodeName);
+				writer.Write(meshNode.MeshName);
+				writer.Write(meshNode.GlobalTransform);
+				writer.Write(meshNode.SkinIndex);
+
+				writer.Write(static_cast<uint64_t>(size(meshNode.Meshes)));
+				for (const auto& mesh : meshNode.Meshes) {
+					writer.Write(mesh.HasNormals);
+					writer.Write(mesh.HasTangents);
+					writer.Write(span<const bool>(mesh.HasTextureCoordinates));
+					writer.Write(mesh.MaterialIndex);
+					writer.Write(mesh.TextureIndex);
+					writer.Write(mesh.IndexFormat);
+					writer.WriteVector(mesh.Vertices);
+					writer.WriteVector(mesh.Indices);
+					writer.WriteVector(mesh.SkeletalVertices);
+					writer.Write(static_cast<uint64_t>(size(mesh.LODs)));
+					for (const auto& LOD : mesh.LODs) {
+						writer.WriteVector(LOD.Indices);
+						writer.Write(LOD.Error);
+					}
+				}
+			}
+
+			AddChunk(ChunkType::Model, name, writer.GetData());
+		}
+
+		void AddAnimationCollection(string_view name, const AnimationCollection& animationCollection) {
+			BinaryWriter writer;
+
+			writer.Write(animationCollection.Name);
+
+			writer.Write(static_cast<uint64_t>(size(animationCollection)));
+			for (const auto& animation : animationCollection) {
+				writer.Write(animation.Name);
+				writer.Write(animation.GetDuration());
+
+				Write(writer, animation.GetTargetNodes());
+
+				const auto& keyframeCollections = animation.GetKeyframeCollections();
+				writer.Write(static_cast<uint64_t>(size(keyframeCollections)));
+				for (const auto& [Name, KeyframeCollection] : keyframeCollections) {
+					writer.Write(Name);
+					writer.WriteVector(KeyframeCollection.Translations);
+					writer.WriteVector(KeyframeCollection.Rotations);
+					writer.WriteVector(KeyframeCollection.Scales);
+				}
+			}
+
+			AddChunk(ChunkType::AnimationCollection, name, writer.GetData());
+		}
+
+		// Images are stored as DDS and shared between models by content
+		string AddImage(const ScratchImage& image, string_view name = {}) {
+			Blob blob;
+			ThrowIfFailed(SaveToDDSMemory(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DDS_FLAGS_NONE, blob));
+
+			const span data(static_cast<const std::byte*>(blob.GetConstBufferPointer()), blob.GetBufferSize());
+
+			string _name(name);
+			if (empty(_name)) {
+				_name = "#" + GetTextureKey(data, 0).ToString();
+			}
+
+			if (!m_chunkIndices.contains(pair(ChunkType::Image, _name))) {
+				AddChunk(ChunkType::Image, _name, data);
+			}
+
+			return _name;
+		}
+
+		auto GetUncompressedSize() const noexcept {
+			uint64_t size = 0;
+			for (const auto& [Entry, _] : m_chunks) {
+				size += Entry.UncompressedSize;
+			}
+			return size;
+		}
+
+		void Save(const path& filePath) const {
+			const auto filePathString = filePath.string();
+
+			ofstream file(filePath, ios::binary | ios::trunc);
+			ThrowIfFailed(static_cast<BOOL>(file.is_open()), filePathString);
+
+			const auto WriteBytes = [&](span<const std::byte> data) {
+				file.write(reinterpret_cast<const char*>(::data(data)), static_cast<streamsize>(size(data)));
+			};
+
+			Header header{ .Version = g_version };
+			ranges::copy(g_magic, header.Magic);
+			WriteBytes(as_bytes(span(&header, 1)));
+
+			BinaryWriter tableOfContents;
+			tableOfContents.Write(static_cast<uint64_t>(size(m_chunks)));
+			for (uint64_t offset = sizeof(header); const auto & [Entry, Data] : m_chunks) {
+				WriteBytes(Data);
+
+				tableOfContents.Write(Entry.Type);
+				tableOfContents.Write(Entry.Name);
+				tableOfContents.Write(Entry.Compression);
+				tableOfContents.Write(offset);
+				tableOfContents.Write(Entry.Size);
+				tableOfContents.Write(Entry.UncompressedSize);
+
+				offset += Entry.Size;
+			}
+
+			header.TableOfContentsOffset = static_cast<uint64_t>(file.tellp());
+			header.TableOfContentsSize = size(tableOfContents.GetData());
+			WriteBytes(tableOfContents.GetData());
+
+			file.seekp(0);
+			WriteBytes(as_bytes(span(&header, 1)));
+
+			if (!file) {
+				throw runtime_error(format("{}: Failed to write scene pack", filePathString));
+			}
+		}
+
+	private:
+		struct Chunk {
+			ChunkEntry Entry;
+			vector<std::byte> Data;
+		};
+		vector<Chunk> m_chunks;
+		map<pair<ChunkType, string>, size_t> m_chunkIndices;
+
+		void AddChunk(ChunkType type, string_view name, span<const std::byte> data) {
+			if (!m_chunkIndices.try_emplace(pair(type, string(name)), size(m_chunks)).second) {
+				throw invalid_argument(format("Scene pack chunk {} is added more than once", name));
+			}
+
+			Chunk chunk{
+				.Entry{
+					.Type = type,
+					.Name = string(name),
+					.Compression = ChunkCompression::None,
+					.Size = size(data),
+					.UncompressedSize = size(data)
+				}
+			};
+
+			if (!empty(data)) {
+				COMPRESSOR_HANDLE handle;
+				ThrowIfFailed(CreateCompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &handle));
+				const unique_ptr<remove_pointer_t<COMPRESSOR_HANDLE>, decltype(&CloseCompressor)> compressor(handle, CloseCompressor);
+
+				SIZE_T compressedSize;
+				if (!::Compress(handle, ::data(data), size(data), nullptr, 0, &compressedSize)) {
+					ThrowIfFailed(static_cast<BOOL>(GetLastError() == ERROR_INSUFFICIENT_BUFFER));
+				}
+				chunk.Data.resize(compressedSize);
+				ThrowIfFailed(::Compress(handle, ::data(data), size(data), ::data(chunk.Data), size(chunk.Data), &compressedSize));
+				chunk.Data.resize(compressedSize);
+
+				// Block-compressed images barely shrink, so they are stored as is to keep loading them free
+				if (compressedSize < size(data) - size(data) / 16) {
+					chunk.Entry.Compression = ChunkCompression::XpressHuffman;
+					chunk.Entry.Size = compressedSize;
+				}
+				else {
+					chunk.Data.assign(cbegin(data), cend(data));
+				}
+			}
+
+			m_chunks.emplace_back(move(chunk));
+		}
+	};
+
+	class ScenePackReader {
+	public:
+		ScenePackReader(const ScenePackReader&) = delete;
+		ScenePackReader& operator=(const ScenePackReader&) = delete;
+
+		explicit ScenePackReader(const path& filePath) noexcept(false) :
+			m_filePath(filePath), m_directory(filePath.parent_path()), m_file(filePath) {
+			try {
+				const auto data = m_file.GetData();
+
+				Header header;
+				if (size(data) < sizeof(header)) {
+					Throw<runtime_error>("Invalid scene pack");
+				}
+				memcpy(&header, ::data(data), sizeof(header));
+				if (!ranges::equal(header.Magic, g_magic)) {
+					Throw<runtime_error>("Invalid scene pack");
+				}
+				if (header.Version != g_version) {
+					Throw<runtime_error>(format("Unsupported scene pack version {}", header.Version));
+				}
+				if (header.TableOfContentsOffset > size(data) || header.TableOfContentsSize > size(data) - header.TableOfContentsOffset) {
+					Throw<runtime_error>("Scene pack table of contents is out of range");
+				}
+
+				BinaryReader reader(data.subspan(header.TableOfContentsOffset, header.TableOfContentsSize));
+				const auto count = reader.Read<uint64_t>();
+				for (uint64_t i = 0; i < count; i++) {
+					ChunkEntry entry;
+					entry.Type = reader.Read<ChunkType>();
+					entry.Name = reader.ReadString();
+					entry.Compression = reader.Read<ChunkCompression>();
+					entry.Offset = reader.Read<uint64_t>();
+					entry.Size = reader.Read<uint64_t>();
+					entry.UncompressedSize = reader.Read<uint64_t>();
+					if (entry.Offset > size(data) || entry.Size > size(data) - entry.Offset) {
+						Throw<runtime_error>(format("Scene pack chunk {} is out of range", entry.Name));
+					}
+					m_chunks.emplace(pair(entry.Type, entry.Name), move(entry));
+				}
+			}
+			catch (const exception& e) {
+				throw runtime_error(format("{}: {}", filePath.string(), e.what()));
+			}
+		}
+
+		const auto& GetFilePath() const noexcept { return m_filePath; }
+
+		string ReadSceneDesc() const {
+			vector<std::byte> buffer;
+			const auto data = ReadChunk(ChunkType::Scene, "", buffer);
+			return { reinterpret_cast<const char*>(::data(data)), size(data) };
+		}
+
+		void ReadModel(ModelData& modelData, const path& filePath) const {
+			vector<std::byte> buffer;
+			BinaryReader reader(ReadChunk(ChunkType::Model, GetScenePackChunkName(filePath, m_directory), buffer));
+
+			modelData.Name = reader.ReadString();
+
+			reader.ReadVector(modelData.Materials);
+			reader.ReadVector(modelData.Textures);
+
+			modelData.Images.resize(reader.Read<uint64_t>());
+			for (auto& [Image, TextureMapType, Key] : modelData.Images) {
+				TextureMapType = reader.Read<uint32_t>();
+				const auto name = reader.ReadString();
+				Image = make_shared<ScratchImage>();
+				ReadImageChunk(*Image, name);
+				// Image chunks are named by content, so models sharing a chunk also share the texture
+				Key = GetTextureKey(as_bytes(span(name)), 0);
+			}
+
+			modelData.Skins.resize(reader.Read<uint64_t>());
+			for (auto& skin : modelData.Skins) {
+				skin.resize(reader.Read<uint64_t>());
+				for (auto& [Name, InverseBindMatrix] : skin) {
+					Name = reader.ReadString();
+					InverseBindMatrix = reader.Read<Matrix>();
+				}
+			}
+
+			modelData.MeshNodes.resize(reader.Read<uint64_t>());
+			for (auto& meshNode : modelData.MeshNodes) {
+				meshNode.NodeName = reader.ReadString();
+				meshNode.MeshName = reader.ReadString();
+				meshNode.GlobalTransform = reader.Read<Matrix>();
+				meshNode.SkinIndex = reader.Read<uint32_t>();
+
+				meshNode.Meshes.resize(reader.Read<uint64_t>());
+				for (auto& mesh : meshNode.Meshes) {
+					mesh.HasNormals = reader.Read<bool>();
+					mesh.HasTangents = reader.Read<bool>();
+					reader.Read(span<bool>(mesh.HasTextureCoordinates));
+					mesh.MaterialIndex = reader.Read<uint32_t>();
+					mesh.TextureIndex = reader.Read<uint32_t>();
+					mesh.IndexFormat = reader.Read<DXGI_FORMAT>();
+					reader.ReadVector(mesh.Vertices);
+					reader.ReadVector(mesh.Indices);
+					reader.ReadVector(mesh.SkeletalVertices);
+					mesh.LODs.resize(reader.Read<uint64_t>());
+					for (auto& LOD : mesh.LODs) {
+						reader.ReadVector(LOD.Indices);
+						LOD.Error = reader.Read<float>();
+					}
+				}
+			}
+		}
+
+		void ReadAnimationCollection(AnimationCollection& animationCollection, const path& filePath) const {
+			vector<std::byte> buffer;
+			BinaryReader reader(ReadChunk(ChunkType::AnimationCollection, GetScenePackChunkName(filePath, m_directory), buffer));
+
+			animationCollection.Name = reader.ReadString();
+
+			const auto count = reader.Read<uint64_t>();
+			animationCollection.reserve(count);
+			for (uint64_t i = 0; i < count; i++) {
+				auto name = reader.ReadString();
+				const auto duration = reader.Read<double>();
+
+				vector<Animation::TargetNode> targetNodes;
+				Read(reader, targetNodes);
+
+				unordered_map<string, KeyframeCollection> keyframeCollections;
+				const auto keyframeCollectionCount = reader.Read<uint64_t>();
+				keyframeCollections.reserve(keyframeCollectionCount);
+				for (uint64_t j = 0; j < keyframeCollectionCount; j++) {
+					auto& keyframeCollection = keyframeCollections[reader.ReadString()];
+					reader.ReadVector(keyframeCollection.Translations);
+					reader.ReadVector(keyframeCollection.Rotations);
+					reader.ReadVector(keyframeCollection.Scales);
+				}
+
+				animationCollection.emplace_back(duration, move(keyframeCollections), targetNodes).Name = move(name);
+			}
+		}
+
+		void ReadImage(ScratchImage& image, const path& filePath) const {
+			ReadImageChunk(image, GetScenePackChunkName(filePath, m_directory));
+		}
+
+	private:
+		path m_filePath, m_directory;
+
+		MemoryMappedFile m_file;
+
+		map<pair<ChunkType, string>, ChunkEntry> m_chunks;
+
+		void ReadImageChunk(ScratchImage& image, const string& name) const {
+			vector<std::byte> buffer;
+			const auto data = ReadChunk(ChunkType::Image, name, buffer);
+			ThrowIfFailed(LoadFromDDSMemory(::data(data), size(data), DDS_FLAGS_NONE, nullptr, image), format("{}: {}", m_filePath.string(), name));
+		}
+
+		// Uncompressed chunks are returned straight from the mapping, compressed ones are inflated into the buffer
+		span<const std::byte> ReadChunk(ChunkType type, const string& name, vector<std::byte>& buffer) const {
+			const auto pChunk = m_chunks.find({ type, name });
+			if (pChunk == cend(m_chunks)) {
+				throw runtime_error(format("{}: Chunk {} not found", m_filePath.string(), name));
+			}
+
+			const auto& entry = pChunk->second;
+			const auto data = m_file.GetData().subspan(entry.Offset, entry.Size);
+			if (entry.Compression == ChunkCompression::None) {
+				return data;
+			}
+
+			DECOMPRESSOR_HANDLE handle;
+			ThrowIfFailed(CreateDecompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &handle));
+			const unique_ptr<remove_pointer_t<DECOMPRESSOR_HANDLE>, decltype(&CloseDecompressor)> decompressor(handle, CloseDecompressor);
+
+			buffer.resize(entry.UncompressedSize);
+			SIZE_T decompressedSize;
+			ThrowIfFailed(Decompress(handle, ::data(data), size(data), ::data(buffer), size(buffer), &decompressedSize), format("{}: {}", m_filePath.string(), name));
+			if (decompressedSize != entry.UncompressedSize) {
+				throw runtime_error(format("{}: Chunk {} is corrupt", m_filePath.string(), name));
+			}
+			return buffer;
+		}
+	};
+}
@@ -0,0 +1,166 @@
+module;
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+
+#include "directx/d3d12.h"
+
+#include "DirectXTex.h"
+
+#include "JSONHelpers.h"
+
+export module ScenePackCooker;
+
+import GLTFHelpers;
+import MeshOptimization;
+import MyScene;
+import ScenePack;
+import TextureCompression;
+import TextureHelpers;
+import ThreadHelpers;
+
+using namespace DirectX;
+using namespace DirectX::TextureHelpers;
+using namespace std;
+using namespace std::chrono;
+using namespace std::filesystem;
+using namespace ThreadHelpers;
+
+namespace {
+	auto GetMilliseconds(steady_clock::duration value) { return duration_cast<duration<double, milli>>(value).count(); }
+}
+
+export {
+	void CookScenePack(const path& sceneFilePath, const path& scenePackFilePath, ostream& log) {
+		const MySceneDesc sceneDesc(sceneFilePath);
+		const auto baseDirectory = sceneFilePath.parent_path();
+
+		// Like Scene::Load, only resources referenced by render objects are packed, once per file
+		vector<pair<string, path>> models, animations;
+		{
+			map<string, path> modelFilePaths, animationFilePaths;
+			for (const auto& renderObject : sceneDesc.RenderObjects) {
+				if (!empty(renderObject.Model)) {
+					const auto& filePath = sceneDesc.Models.at(renderObject.Model);
+					modelFilePaths.try_emplace(GetScenePackChunkName(filePath, baseDirectory), filePath);
+				}
+
+				if (!empty(renderObject.Animation)) {
+					const auto& filePath = sceneDesc.Animations.at(renderObject.Animation);
+					animationFilePaths.try_emplace(GetScenePackChunkName(filePath, baseDirectory), filePath);
+				}
+			}
+			models.assign(cbegin(modelFilePaths), cend(modelFilePaths));
+			animations.assign(cbegin(animationFilePaths), cend(animationFilePaths));
+		}
+
+		vector<ModelData> modelData(size(models));
+		vector<AnimationCollection> animationCollections(size(animations));
+		const auto GLTFStartTime = steady_clock::now();
+		{
+			GLTFHelpers::AssetCache assetCache;
+
+			// Packs carry LODs, which loads drop unless they select LODs
+			ParallelFor(size(models), [&](size_t index) {
+				GLTFHelpers::DecodeModel(modelData[index], *assetCache.Load(models[index].second), true, nullptr, { .LOD{ .IsEnabled = true } });
+			});
+
+			ParallelFor(size(animations), [&](size_t index) {
+				GLTFHelpers::LoadAnimation(animationCollections[index], *assetCache.Load(animations[index].second));
+			});
+		}
+		const auto GLTFDuration = steady_clock::now() - GLTFStartTime;
+
+		size_t vertexCount = 0, meshDataSize = 0;
+		for (const auto& model : modelData) {
+			for (const auto& meshNode : model.MeshNodes) {
+				for (const auto& mesh : meshNode.Meshes) {
+					vertexCount += size(mesh.Vertices);
+					meshDataSize += span(mesh.Vertices).size_bytes() + size(mesh.Indices) + span(mesh.SkeletalVertices).size_bytes();
+				}
+			}
+		}
+
+		ScenePackWriter writer;
+
+		const auto cookingStartTime = steady_clock::now();
+		{
+			vector<ImageData*> images;
+			for (auto& model : modelData) {
+				for (auto& image : model.Images) {
+					images.emplace_back(&image);
+				}
+			}
+			ParallelFor(size(images), [&](size_t index) {
+				CompressTexture(*images[index]->Image, GetBlockCompressedFormat(images[index]->TextureMapType));
+			});
+
+			for (size_t i = 0; const auto & [Name, _] : models) {
+				writer.AddModel(Name, modelData[i++]);
+			}
+
+			for (size_t i = 0; const auto & [Name, _] : animations) {
+				writer.AddAnimationCollection(Name, animationCollections[i++]);
+			}
+
+			SceneDesc packedSceneDesc = sceneDesc;
+			packedSceneDesc.ScenePack = nullptr;
+
+			if (auto& filePath = packedSceneDesc.EnvironmentLight.Texture; !empty(filePath)) {
+				ScratchImage image;
+				DecodeTexture(image, filePath, true);
+				CompressTexture(image, DXGI_FORMAT_BC7_UNORM);
+				filePath = writer.AddImage(image, GetScenePackChunkName(filePath, baseDirectory));
+			}
+
+			for (auto& filePaths : { &packedSceneDesc.Models, &packedSceneDesc.Animations }) {
+				for (auto& filePath : *filePaths | views::values) {
+					filePath = GetScenePackChunkName(filePath, baseDirectory);
+				}
+			}
+
+			writer.AddSceneDesc(ordered_json_f(packedSceneDesc).dump());
+
+			writer.Save(scenePackFilePath);
+		}
+		const auto cookingDuration = steady_clock::now() - cookingStartTime;
+
+		const auto scenePackStartTime = steady_clock::now();
+		{
+			const MySceneDesc packedSceneDesc(scenePackFilePath);
+			const auto& reader = *packedSceneDesc.ScenePack;
+			const auto packDirectory = scenePackFilePath.parent_path();
+
+			vector<ModelData> modelData(size(models));
+			ParallelFor(size(models), [&](size_t index) { reader.ReadModel(modelData[index], packDirectory / models[index].first); });
+
+			vector<AnimationCollection> animationCollections(size(animations));
+			ParallelFor(size(animations), [&](size_t index) {
+				reader.ReadAnimationCollection(animationCollections[index], packDirectory / animations[index].first);
+			});
+		}
+		const auto scenePackDuration = steady_clock::now() - scenePackStartTime;
+
+		log << format(
+			"{} -> {}\n"
+			"Models: {}, animations: {}\n"
+			"Mesh data: {} vertices, {} bytes\n"
+			"Size: {} bytes ({} bytes before chunk compression)\n"
+			"Cooking: {:.1f} ms\n"
+			"Load from glTF (parse and decode): {:.1f} ms ({:.1f} ms per million vertices)\n"
+			"Load from scene pack (map, decompress and read): {:.1f} ms\n",
+			sceneFilePath.string(), scenePackFilePath.string(),
+			size(models), size(animations),
+			vertexCount, meshDataSize,
+			file_size(scenePackFilePath), writer.GetUncompressedSize(),
+			GetMilliseconds(cookingDuration),
+			GetMilliseconds(GLTFDuration), vertexCount ? GetMilliseconds(GLTFDuration) * 1'000'000 / vertexCount : 0.0,
+			GetMilliseconds(scenePackDuration)
+		);
+	}
+}
@@ -12,6 +12,7 @@ import CommandList;
 import DeviceContext;
 import ErrorHelpers;
 import GPUBuffer;
+import Vertex;
 
 using namespace DirectX;
 using namespace ErrorHelpers;
@@ -39,7 +40,7 @@ export struct SkeletalMeshSkinning {
 		commandList->SetPipelineState(m_pipelineState.Get());
 	}
 
-	void Process(CommandList& commandList) {
+	void Process(CommandList& commandList, const SkinDesc& skinDesc) {
 		const auto vertexCount = static_cast<uint32_t>(GPUBuffers.Vertices->GetCapacity());
 
 		commandList.SetState(*GPUBuffers.SkeletalVertices, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
@@ -47,7 +48,11 @@ export struct SkeletalMeshSkinning {
 		commandList.SetState(*GPUBuffers.Vertices, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		commandList.SetState(*GPUBuffers.MotionVectors, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
-		commandList->SetComputeRoot32BitConstant(0, vertexCount, 0);
+		const struct {
+			SkinDesc SkinDesc;
+			uint32_t VertexCount;
+		} constants{ skinDesc, vertexCount };
+		commandList->SetComputeRoot32BitConstants(0, sizeof(constants) / sizeof(uint32_t), &constants, 0);
 		commandList->SetComputeRootShaderResourceView(1, GPUBuffers.SkeletalVertices->GetNative()->GetGPUVirtualAddress());
 		commandList->SetComputeRootShaderResourceView(2, GPUBuffers.SkeletalTransforms->GetNative()->GetGPUVirtualAddress());
 		commandList->SetComputeRootUnorderedAccessView(3, GPUBuffers.Vertices->GetNative()->GetGPUVirtualAddress());
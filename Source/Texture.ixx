@@ -1,6 +1,7 @@
 module;
 
 #include <stdexcept>
+#include <utility>
 
 #include "directx/d3dx12.h"
 
@@ -142,7 +143,11 @@ export namespace DirectX {
 		const auto& GetRTVDescriptor(UINT16 mipLevel = 0) const noexcept { return *m_descriptors.RTV[mipLevel]; }
 		const auto& GetDSVDescriptor(UINT16 mipLevel = 0) const noexcept { return *m_descriptors.DSV[mipLevel]; }
 
-		void CreateSRV() {
+		/*
+		 * 2D textures are viewed as arrays when isArray is set, even with a single slice.
+		 * Sampling is clamped to mips from minLODClamp on, which lets textures be sampled before their finer mips are uploaded.
+		 */
+		void CreateSRV(bool isArray = false, float minLODClamp = 0) {
 			auto& descriptor = m_descriptors.SRV;
 			if (descriptor) {
 				return;
@@ -165,41 +170,53 @@ export namespace DirectX {
 						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
 						SRVDesc.Texture1DArray = {
 							.MipLevels = mipLevels,
-							.ArraySize = desc.DepthOrArraySize
+							.ArraySize = desc.DepthOrArraySize,
+							.ResourceMinLODClamp = minLODClamp
 						};
 					}
 					else {
 						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
-						SRVDesc.Texture1D.MipLevels = mipLevels;
+						SRVDesc.Texture1D = {
+							.MipLevels = mipLevels,
+							.ResourceMinLODClamp = minLODClamp
+						};
 					}
 				}
 				break;
 
 				case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
 				{
-					if (desc.DepthOrArraySize % 6 == 0) {
+					if (!isArray && desc.DepthOrArraySize % 6 == 0) {
 						if (desc.DepthOrArraySize > 6) {
 							SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
 							SRVDesc.TextureCubeArray = {
 								.MipLevels = mipLevels,
-								.NumCubes = desc.DepthOrArraySize / 6u
+								.NumCubes = desc.DepthOrArraySize / 6u,
+								.ResourceMinLODClamp = minLODClamp
 							};
 						}
 						else {
 							SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-							SRVDesc.TextureCube.MipLevels = mipLevels;
+							SRVDesc.TextureCube = {
+								.MipLevels = mipLevels,
+								.ResourceMinLODClamp = minLODClamp
+							};
 						}
 					}
-					else if (desc.DepthOrArraySize > 1) {
+					else if (isArray || desc.DepthOrArraySize > 1) {
 						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
 						SRVDesc.Texture2DArray = {
 							.MipLevels = mipLevels,
-							.ArraySize = desc.DepthOrArraySize
+							.ArraySize = desc.DepthOrArraySize,
+							.ResourceMinLODClamp = minLODClamp
 						};
 					}
 					else {
 						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-						SRVDesc.Texture2D.MipLevels = mipLevels;
+						SRVDesc.Texture2D = {
+							.MipLevels = mipLevels,
+							.ResourceMinLODClamp = minLODClamp
+						};
 					}
 				}
 				break;
@@ -207,7 +224,10 @@ export namespace DirectX {
 				case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
 				{
 					SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
-					SRVDesc.Texture3D.MipLevels = mipLevels;
+					SRVDesc.Texture3D = {
+						.MipLevels = mipLevels,
+						.ResourceMinLODClamp = minLODClamp
+					};
 				}
 				break;
 			}
@@ -216,6 +236,24 @@ export namespace DirectX {
 			m_deviceContext.Device->CreateShaderResourceView(*this, &SRVDesc, *descriptor);
 		}
 
+		// Recreates the SRV in a new descriptor; the previous one is returned, as frames in flight may still read it
+		[[nodiscard]] unique_ptr<Descriptor> ResetSRV(bool isArray = false, float minLODClamp = 0) {
+			auto descriptor = move(m_descriptors.SRV);
+			CreateSRV(isArray, minLODClamp);
+			return descriptor;
+		}
+
+		/*
+		 * Exchanges the resources, states and views of the textures, so that holders of this texture sample what other held.
+		 * Lets a texture be reallocated, for example with more or fewer mips, while frames in flight still read the previous resource through other.
+		 */
+		void Swap(Texture& other) noexcept {
+			swap(m_allocation, other.m_allocation);
+			swap(m_resource, other.m_resource);
+			swap(m_state, other.m_state);
+			swap(m_descriptors, other.m_descriptors);
+		}
+
 		void CreateUAV(UINT16 mipLevel = 0) {
 			auto& descriptor = m_descriptors.UAV[mipLevel];
 			if (descriptor) {
@@ -0,0 +1,187 @@
+module;
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+
+#include <Windows.h>
+#include <bcrypt.h>
+
+#include "directx/d3d12.h"
+
+#include "DirectXTex.h"
+
+export module TextureCompression;
+
+import ErrorHelpers;
+import MemoryMappedFile;
+import MipChainGeneration;
+
+using namespace DirectX;
+using namespace ErrorHelpers;
+using namespace std;
+using namespace std::filesystem;
+
+export namespace DirectX::TextureHelpers {
+	struct TextureCompressionDesc {
+		bool IsEnabled{};
+
+		// Compressed images are persisted there across runs, unless empty
+		path CacheDirectoryPath;
+	};
+
+	// Bumped whenever decoding or compression changes what a texture key stands for, which retires every cached texture
+	constexpr uint32_t TextureKeyVersion = 1;
+
+	// Identifies an encoded image together with the settings it is decoded with, the same across runs, builds and machines
+	struct TextureKey {
+		// SHA-256 of TextureKeyVersion, the settings and the encoded image
+		array<std::byte, 32> Digest{};
+
+		uint64_t SourceSize{};
+
+		explicit operator bool() const noexcept { return Digest != decltype(Digest){}; }
+
+		bool operator==(const TextureKey&) const = default;
+
+		// The digest is already uniformly distributed, so any of its words will do
+		struct Hasher {
+			size_t operator()(const TextureKey& key) const noexcept {
+				size_t value;
+				memcpy(&value, ::data(key.Digest), sizeof(value));
+				return value;
+			}
+		};
+
+		string ToString() const {
+			string value;
+			value.reserve(size(Digest) * 2);
+			for (const auto byte : Digest) {
+				value += format("{:02x}", to_integer<uint32_t>(byte));
+			}
+			return value;
+		}
+	};
+
+	TextureKey GetTextureKey(span<const std::byte> data, uint64_t settings) {
+		const auto ThrowIfFailed = [](NTSTATUS status) { ErrorHelpers::ThrowIfFailed(HRESULT_FROM_NT(status)); };
+
+		BCRYPT_HASH_HANDLE hash;
+		ThrowIfFailed(BCryptCreateHash(BCRYPT_SHA256_ALG_HANDLE, &hash, nullptr, 0, nullptr, 0, 0));
+		const unique_ptr<void, decltype(&BCryptDestroyHash)> hashOwner(hash, BCryptDestroyHash);
+
+		const auto Hash = [&](const void* pData, size_t size) {
+			for (size_t offset = 0; offset < size;) {
+				const auto chunkSize = static_cast<ULONG>(min<size_t>(size - offset, ULONG_MAX));
+				ThrowIfFailed(BCryptHashData(hash, static_cast<PUCHAR>(const_cast<void*>(pData)) + offset, chunkSize, 0));
+				offset += chunkSize;
+			}
+		};
+		Hash(&TextureKeyVersion, sizeof(TextureKeyVersion));
+		Hash(&settings, sizeof(settings));
+		Hash(::data(data), size(data));
+
+		TextureKey key{ .SourceSize = size(data) };
+		ThrowIfFailed(BCryptFinishHash(hash, reinterpret_cast<PUCHAR>(::data(key.Digest)), static_cast<ULONG>(size(key.Digest)), 0));
+		return key;
+	}
+
+	/*
+	 * Generates the mip chain unless already done and block-compresses the image to format, or to BC6H if its pixels are floating-point.
+	 * The sRGB-ness of the image is kept, and images that are already compressed or whose top level is not
+	 * a multiple of the block size are left uncompressed.
+	 */
+	void CompressTexture(ScratchImage& image, DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT) {
+		if (IsCompressed(image.GetMetadata().format)) {
+			return;
+		}
+
+		GenerateMipChain(image);
+
+		const auto& metadata = image.GetMetadata();
+		if (metadata.width % 4 || metadata.height % 4) {
+			return;
+		}
+
+		if (FormatDataType(metadata.format) == FORMAT_TYPE_FLOAT) {
+			format = DXGI_FORMAT_BC6H_UF16;
+		}
+		else if (IsSRGB(metadata.format)) {
+			format = MakeSRGB(format);
+		}
+		ScratchImage compressedImage;
+		ThrowIfFailed(Compress(image.GetImages(), image.GetImageCount(), metadata, format, flags | TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, compressedImage));
+		image = move(compressedImage);
+	}
+
+	/*
+	 * Reads the image cached under textureKey in cacheDirectoryPath, or runs decoder and caches its result if block-compressed.
+	 * Cached files start with a header repeating the key, which must match before the DDS data after it is used.
+	 * The cache is best effort: unreadable or mismatching entries are decoded again and failed writes are ignored.
+	 */
+	template <typename Decoder>
+	void LoadCachedTexture(ScratchImage& image, const TextureKey& textureKey, const path& cacheDirectoryPath, Decoder&& decoder) {
+		if (empty(cacheDirectoryPath) || !textureKey) {
+			decoder(image);
+			return;
+		}
+
+		struct Header {
+			char Magic[4]{ 'T', 'E', 'X', 'C' };
+			uint32_t Version = TextureKeyVersion;
+			uint64_t SourceSize{};
+			array<std::byte, 32> Digest{};
+		};
+		const Header header{ .SourceSize = textureKey.SourceSize, .Digest = textureKey.Digest };
+
+		const auto filePath = cacheDirectoryPath / (textureKey.ToString() + ".texture");
+		if (error_code errorCode; exists(filePath, errorCode)) {
+			try {
+				const MemoryMappedFile file(filePath);
+				if (const auto data = file.GetData();
+					size(data) > sizeof(header) && !memcmp(::data(data), &header, sizeof(header))
+					&& SUCCEEDED(LoadFromDDSMemory(reinterpret_cast<const uint8_t*>(::data(data)) + sizeof(header), size(data) - sizeof(header), DDS_FLAGS_NONE, nullptr, image))) {
+					return;
+				}
+			}
+			catch (...) {
+				// Decoded again below
+			}
+		}
+
+		decoder(image);
+
+		if (!IsCompressed(image.GetMetadata().format)) {
+			return;
+		}
+
+		Blob blob;
+		if (FAILED(SaveToDDSMemory(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DDS_FLAGS_NONE, blob))) {
+			return;
+		}
+
+		// Written aside and renamed, so that other threads or processes never read a partial file
+		error_code errorCode;
+		create_directories(cacheDirectoryPath, errorCode);
+		auto temporaryFilePath = filePath;
+		temporaryFilePath += format(L".{}.tmp", hash<thread::id>()(this_thread::get_id()));
+		{
+			ofstream file(temporaryFilePath, ios::binary | ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(static_cast<const char*>(blob.GetConstBufferPointer()), static_cast<streamsize>(blob.GetBufferSize()));
+			if (!file.good()) {
+				file.close();
+				remove(temporaryFilePath, errorCode);
+				return;
+			}
+		}
+		if (rename(temporaryFilePath, filePath, errorCode); errorCode) {
+			remove(temporaryFilePath, errorCode);
+		}
+	}
+}
@@ -1,19 +1,28 @@
 module;
 
+#include <execution>
 #include <filesystem>
+#include <mutex>
 #include <span>
+#include <thread>
 
 #include "directx/d3d12.h"
 
 #include "DirectXTexEXR.h"
 
+#include "OpenEXR/ImfThreading.h"
+
+#include "basisu/transcoder/basisu_transcoder.h"
+
 export module TextureHelpers;
 
+export import ImageDecoders;
 export import Texture;
 
 import CommandList;
 import DeviceContext;
 import ErrorHelpers;
+import MemoryMappedFile;
 
 using namespace DirectX;
 using namespace ErrorHelpers;
@@ -25,6 +34,79 @@ using namespace std::filesystem;
 	ThrowIfFailed(Loader(::data(data), size(data), __VA_ARGS__, nullptr, image)); \
 	return LoadTexture(commandList, image, forceSRGB);
 
+namespace {
+	// OpenEXR decodes the line buffers and tiles of each image on its global thread pool, which has no threads by default
+	void EnableEXRThreading() {
+		static once_flag initialized;
+		call_once(initialized, [] { Imf::setGlobalThreadCount(static_cast<int>(thread::hardware_concurrency())); });
+	}
+
+	void TranscodeKTX2(span<const std::byte> data, DXGI_FORMAT format, ScratchImage& image) {
+		static once_flag initialized;
+		call_once(initialized, basist::basisu_transcoder_init);
+
+		basist::transcoder_texture_format targetFormat;
+		switch (format) {
+			case DXGI_FORMAT_BC4_UNORM: targetFormat = basist::transcoder_texture_format::cTFBC4_R; break;
+			case DXGI_FORMAT_BC5_UNORM: targetFormat = basist::transcoder_texture_format::cTFBC5_RG; break;
+			case DXGI_FORMAT_BC7_UNORM: targetFormat = basist::transcoder_texture_format::cTFBC7_RGBA; break;
+			default: Throw<invalid_argument>("KTX2 images can only be transcoded to BC4, BC5 or BC7");
+		}
+
+		basist::ktx2_transcoder transcoder;
+		if (!transcoder.init(::data(data), static_cast<uint32_t>(size(data))) || !transcoder.start_transcoding()) {
+			Throw<runtime_error>("Invalid KTX2 image");
+		}
+
+		const auto
+			levels = max(transcoder.get_levels(), 1u),
+			layers = max(transcoder.get_layers(), 1u),
+			faces = max(transcoder.get_faces(), 1u);
+		if (faces == 6) {
+			ThrowIfFailed(image.InitializeCube(format, transcoder.get_width(), transcoder.get_height(), layers, levels));
+		}
+		else {
+			ThrowIfFailed(image.Initialize2D(format, transcoder.get_width(), transcoder.get_height(), layers, levels));
+		}
+
+		struct Subresource { uint32_t Level, Layer, Face; };
+		vector<Subresource> subresources;
+		subresources.reserve(levels * layers * faces);
+		for (uint32_t level = 0; level < levels; level++) {
+			for (uint32_t layer = 0; layer < layers; layer++) {
+				for (uint32_t face = 0; face < faces; face++) {
+					subresources.emplace_back(level, layer, face);
+				}
+			}
+		}
+
+		const auto blockSize = static_cast<uint32_t>(BitsPerPixel(format) * 2);
+		atomic_bool succeeded = true;
+		for_each(
+			execution::par,
+			cbegin(subresources), cend(subresources),
+			[&](const Subresource& subresource) {
+				// Transcoding from multiple threads requires a separate state for each call
+				basist::ktx2_transcoder_state state;
+		const auto& [Level, Layer, Face] = subresource;
+		const auto& output = *image.GetImage(Level, Layer * faces + Face, 0);
+		if (!transcoder.transcode_image_level(
+			Level, Layer, Face,
+			output.pixels, static_cast<uint32_t>(output.slicePitch / blockSize),
+			targetFormat,
+			0, static_cast<uint32_t>(output.rowPitch / blockSize), 0, -1, -1,
+			&state
+		)) {
+			succeeded = false;
+		}
+			}
+		);
+		if (!succeeded) {
+			Throw<runtime_error>("Failed to transcode KTX2 image");
+		}
+	}
+}
+
 #define LOAD_FROM_FILE(Loader, forceSRGB, ...) \
 	ScratchImage image; \
 	ThrowIfFailed(Loader(filePath.c_str(), __VA_ARGS__, nullptr, image), filePath.string()); \
@@ -95,6 +177,7 @@ export namespace DirectX::TextureHelpers {
 	}
 
 	unique_ptr<Texture> LoadEXR(CommandList& commandList, const path& filePath) {
+		EnableEXRThreading();
 		LOAD_FROM_FILE(LoadFromEXRFile, false);
 	}
 
@@ -106,17 +189,68 @@ export namespace DirectX::TextureHelpers {
 		LOAD_FROM_FILE(LoadFromTGAFile, false, flags);
 	}
 
-	unique_ptr<Texture> LoadTexture(CommandList& commandList, string_view format, span<const std::byte> data, bool forceSRGB = false) {
-		const auto _format = ::data(format);
-		auto texture =
-			!_stricmp(_format, "dds") ? LoadDDS(commandList, data, forceSRGB) :
-			!_stricmp(_format, "hdr") ? LoadHDR(commandList, data) :
-			!_stricmp(_format, "tga") ? LoadTGA(commandList, data, forceSRGB ? TGA_FLAGS_DEFAULT_SRGB : TGA_FLAGS_NONE) :
-			LoadWIC(commandList, data, forceSRGB ? WIC_FLAGS_DEFAULT_SRGB : WIC_FLAGS_NONE);
-		return texture;
+	void DecodeKTX2(ScratchImage& image, span<const std::byte> data, DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM) {
+		TranscodeKTX2(data, format, image);
+	}
+
+	void DecodeKTX2(ScratchImage& image, const path& filePath, DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM) {
+		try {
+			TranscodeKTX2(MemoryMappedFile(filePath).GetData(), format, image);
+		}
+		catch (const exception& e) {
+			throw runtime_error(std::format("{}: {}", filePath.string(), e.what()));
+		}
+	}
+
+	unique_ptr<Texture> LoadKTX2(
+		CommandList& commandList,
+		span<const std::byte> data,
+		DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM, bool forceSRGB = false
+	) {
+		ScratchImage image;
+		DecodeKTX2(image, data, format);
+		return LoadTexture(commandList, image, forceSRGB);
 	}
 
-	unique_ptr<Texture> LoadTexture(CommandList& commandList, const path& filePath, bool forceSRGB = false) {
+	unique_ptr<Texture> LoadKTX2(
+		CommandList& commandList,
+		const path& filePath,
+		DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM, bool forceSRGB = false
+	) {
+		ScratchImage image;
+		DecodeKTX2(image, filePath, format);
+		return LoadTexture(commandList, image, forceSRGB);
+	}
+
+	// Decoded images carry their final format, so forceSRGB does not need to be passed again on upload
+	void DecodeTexture(
+		ScratchImage& image,
+		string_view format, span<const std::byte> data,
+		bool forceSRGB = false, ImageDecoder decoder = ImageDecoder::Portable
+	) {
+		const auto _format = ::data(format), _data = ::data(data);
+		const auto _size = size(data);
+		if (!_stricmp(_format, "ktx2") || !_stricmp(_format, "dds")) {
+			if (!_stricmp(_format, "ktx2")) {
+				DecodeKTX2(image, data);
+			}
+			else {
+				ThrowIfFailed(LoadFromDDSMemory(_data, _size, DDS_FLAGS_NONE, nullptr, image));
+			}
+			if (forceSRGB) {
+				image.OverrideFormat(MakeSRGB(image.GetMetadata().format));
+			}
+		}
+		else if (decoder != ImageDecoder::Portable || !DecodePortableImage(image, data, forceSRGB)) {
+			ThrowIfFailed(
+				!_stricmp(_format, "hdr") ? LoadFromHDRMemory(_data, _size, nullptr, image) :
+				!_stricmp(_format, "tga") ? LoadFromTGAMemory(_data, _size, forceSRGB ? TGA_FLAGS_DEFAULT_SRGB : TGA_FLAGS_NONE, nullptr, image) :
+				LoadFromWICMemory(_data, _size, forceSRGB ? WIC_FLAGS_DEFAULT_SRGB : WIC_FLAGS_NONE, nullptr, image)
+			);
+		}
+	}
+
+	void DecodeTexture(ScratchImage& image, const path& filePath, bool forceSRGB = false, ImageDecoder decoder = ImageDecoder::Portable) {
 		if (empty(filePath)) {
 			throw invalid_argument("Texture file path cannot be empty");
 		}
@@ -126,13 +260,58 @@ export namespace DirectX::TextureHelpers {
 			throw invalid_argument(format("{}: Unknown file format", filePath.string()));
 		}
 
-		const auto extension = filePathExtension.c_str() + 1;
-		auto texture =
-			!_wcsicmp(extension, L"dds") ? LoadDDS(commandList, filePath, forceSRGB) :
-			!_wcsicmp(extension, L"hdr") ? LoadHDR(commandList, filePath) :
-			!_wcsicmp(extension, L"exr") ? LoadEXR(commandList, filePath) :
-			!_wcsicmp(extension, L"tga") ? LoadTGA(commandList, filePath, forceSRGB ? TGA_FLAGS_DEFAULT_SRGB : TGA_FLAGS_NONE) :
-			LoadWIC(commandList, filePath, forceSRGB ? WIC_FLAGS_DEFAULT_SRGB : WIC_FLAGS_NONE);
-		return texture;
+		const auto extension = filePathExtension.c_str() + 1, _filePath = filePath.c_str();
+		if (!_wcsicmp(extension, L"ktx2") || !_wcsicmp(extension, L"dds")) {
+			if (!_wcsicmp(extension, L"ktx2")) {
+				DecodeKTX2(image, filePath);
+			}
+			else {
+				ThrowIfFailed(LoadFromDDSFile(_filePath, DDS_FLAGS_NONE, nullptr, image), filePath.string());
+			}
+			if (forceSRGB) {
+				image.OverrideFormat(MakeSRGB(image.GetMetadata().format));
+			}
+		}
+		else if (decoder == ImageDecoder::Portable
+			&& (!_wcsicmp(extension, L"png") || !_wcsicmp(extension, L"jpg") || !_wcsicmp(extension, L"jpeg"))) {
+			try {
+				DecodeTexture(image, "", MemoryMappedFile(filePath).GetData(), forceSRGB, decoder);
+			}
+			catch (const exception& e) {
+				throw runtime_error(std::format("{}: {}", filePath.string(), e.what()));
+			}
+		}
+		else {
+			if (!_wcsicmp(extension, L"exr")) {
+				EnableEXRThreading();
+			}
+			ThrowIfFailed(
+				!_wcsicmp(extension, L"hdr") ? LoadFromHDRFile(_filePath, nullptr, image) :
+				!_wcsicmp(extension, L"exr") ? LoadFromEXRFile(_filePath, nullptr, image) :
+				!_wcsicmp(extension, L"tga") ? LoadFromTGAFile(_filePath, forceSRGB ? TGA_FLAGS_DEFAULT_SRGB : TGA_FLAGS_NONE, nullptr, image) :
+				LoadFromWICFile(_filePath, forceSRGB ? WIC_FLAGS_DEFAULT_SRGB : WIC_FLAGS_NONE, nullptr, image),
+				filePath.string()
+			);
+		}
+	}
+
+	unique_ptr<Texture> LoadTexture(
+		CommandList& commandList,
+		string_view format, span<const std::byte> data,
+		bool forceSRGB = false, ImageDecoder decoder = ImageDecoder::Portable
+	) {
+		ScratchImage image;
+		DecodeTexture(image, format, data, forceSRGB, decoder);
+		return LoadTexture(commandList, image);
+	}
+
+	unique_ptr<Texture> LoadTexture(
+		CommandList& commandList,
+		const path& filePath,
+		bool forceSRGB = false, ImageDecoder decoder = ImageDecoder::Portable
+	) {
+		ScratchImage image;
+		DecodeTexture(image, filePath, forceSRGB, decoder);
+		return LoadTexture(commandList, image);
 	}
 }
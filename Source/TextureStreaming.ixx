@@ -0,0 +1,524 @@
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "directx/d3dx12.h"
+
+#include "DirectXTex.h"
+
+export module TextureStreaming;
+
+import CommandList;
+import DeviceContext;
+import ErrorHelpers;
+import MemoryMappedFile;
+import Texture;
+
+using namespace DirectX;
+using namespace ErrorHelpers;
+using namespace std;
+
+export {
+	/*
+	 * Decides which mips of streamed textures are resident within a memory budget, without touching the GPU,
+	 * so that it can be driven by simulated feedback.
+	 * Mips are numbered from the most detailed one, and a texture always has the mips from its resident mip to the last.
+	 * The coarsest mips, its tail, are uploaded at load and never evicted.
+	 * Each frame, feedback reports the most detailed mip that sampling asked for; Update then issues loads one mip at a time,
+	 * most starved textures first, and evicts mips that are beyond the requests or, failing that, least recently requested.
+	 * Not thread-safe: loaders report completions through OnLoaded on the thread that calls Update.
+	 */
+	class TextureResidencyManager {
+	public:
+		using TextureID = uint32_t;
+
+		enum class CommandType { Load, Evict };
+
+		struct Command {
+			CommandType Type;
+			TextureID ID;
+
+			// For loads, the mip to upload; for evictions, the new resident mip, finer mips being released
+			uint32_t Mip;
+		};
+
+		struct Usage {
+			size_t TextureCount, Resident, Pending;
+		};
+
+		explicit TextureResidencyManager(size_t budget) : m_budget(budget) {}
+
+		// Number of mips, coarsest first, that fit in tailSize bytes; at least 1 so that every texture can be sampled
+		static uint32_t GetTailMipCount(span<const size_t> mipSizes, size_t tailSize) {
+			uint32_t count = 0;
+			size_t size = 0;
+			for (auto mip = std::size(mipSizes); mip-- > 0 && (size += mipSizes[mip]) <= tailSize;) {
+				count++;
+			}
+			return max(count, min<uint32_t>(static_cast<uint32_t>(std::size(mipSizes)), 1));
+		}
+
+		TextureID Register(span<const size_t> mipSizes, uint32_t tailMipCount) {
+			if (empty(mipSizes)) {
+				Throw<invalid_argument>("Streamed texture must have at least one mip");
+			}
+			if (!tailMipCount || tailMipCount > size(mipSizes)) {
+				Throw<out_of_range>("Tail mip count must be within the mip count");
+			}
+
+			TextureID ID;
+			if (empty(m_freeIDs)) {
+				ID = static_cast<TextureID>(size(m_textures));
+				m_textures.emplace_back();
+			}
+			else {
+				ID = m_freeIDs.back();
+				m_freeIDs.pop_back();
+			}
+
+			auto& texture = m_textures[ID];
+			texture = {
+				.IsRegistered = true,
+				.MipSizes = { cbegin(mipSizes), cend(mipSizes) },
+				.TailMip = static_cast<uint32_t>(size(mipSizes)) - tailMipCount
+			};
+			texture.ResidentMip = texture.RequestedMip = texture.TailMip;
+			for (auto mip = texture.TailMip; mip < size(mipSizes); mip++) {
+				m_usage.Resident += mipSizes[mip];
+			}
+			m_usage.TextureCount++;
+			return ID;
+		}
+
+		// Completions of loads still pending for the texture are ignored afterwards
+		void Unregister(TextureID ID) {
+			auto& texture = GetTexture(ID);
+			for (auto mip = texture.ResidentMip; mip < size(texture.MipSizes); mip++) {
+				m_usage.Resident -= texture.MipSizes[mip];
+			}
+			if (texture.PendingMip != NoMip) {
+				m_usage.Pending -= texture.MipSizes[texture.PendingMip];
+			}
+			m_usage.TextureCount--;
+			texture = {};
+			m_freeIDs.emplace_back(ID);
+		}
+
+		// Reports that mip was requested in frame; requests of the same frame are combined
+		void RequestMip(TextureID ID, uint32_t mip, uint64_t frame) {
+			auto& texture = GetTexture(ID);
+			mip = min(mip, texture.TailMip);
+			if (frame != texture.LastRequestFrame) {
+				texture.RequestedMip = mip;
+				texture.LastRequestFrame = frame;
+			}
+			else {
+				texture.RequestedMip = min(texture.RequestedMip, mip);
+			}
+		}
+
+		void OnLoaded(TextureID ID, uint32_t mip) {
+			if (ID >= size(m_textures)) {
+				return;
+			}
+			auto& texture = m_textures[ID];
+			if (!texture.IsRegistered || texture.PendingMip != mip) {
+				return;
+			}
+			const auto mipSize = texture.MipSizes[mip];
+			m_usage.Pending -= mipSize;
+			m_usage.Resident += mipSize;
+			texture.ResidentMip = mip;
+			texture.PendingMip = NoMip;
+		}
+
+		/*
+		 * Loads for textures requested in frame, the latest frame feedback was reported for, at most maxLoadCount,
+		 * preceded by the evictions they need and those that bring usage back within a lowered budget.
+		 * Evictions are applied at once, so the caller must stop sampling the released mips before freeing them.
+		 */
+		vector<Command> Update(uint64_t frame, size_t maxLoadCount = ~0ull) {
+			vector<Command> commands;
+
+			const auto Evict = [&](TextureID victimID) {
+				auto& victim = m_textures[victimID];
+				m_usage.Resident -= victim.MipSizes[victim.ResidentMip++];
+				commands.emplace_back(CommandType::Evict, victimID, victim.ResidentMip);
+			};
+
+			while (m_usage.Resident + m_usage.Pending > m_budget) {
+				const auto victimID = FindEvictionVictim(NoTexture, frame);
+				if (victimID == NoTexture) {
+					break;
+				}
+				Evict(victimID);
+			}
+
+			vector<TextureID> candidates;
+			for (TextureID ID = 0; const auto & texture : m_textures) {
+				if (texture.IsRegistered && texture.LastRequestFrame == frame
+					&& texture.PendingMip == NoMip && texture.RequestedMip < texture.ResidentMip) {
+					candidates.emplace_back(ID);
+				}
+				ID++;
+			}
+			ranges::stable_sort(candidates, greater(), [&](TextureID ID) {
+				const auto& texture = m_textures[ID];
+				return texture.ResidentMip - texture.RequestedMip;
+			});
+
+			for (size_t loadCount = 0; const auto ID : candidates) {
+				if (loadCount++ == maxLoadCount) {
+					break;
+				}
+
+				auto& texture = m_textures[ID];
+				const auto mip = texture.ResidentMip - 1;
+				const auto mipSize = texture.MipSizes[mip];
+				while (m_usage.Resident + m_usage.Pending + mipSize > m_budget) {
+					const auto victimID = FindEvictionVictim(ID, frame);
+					if (victimID == NoTexture) {
+						return commands;
+					}
+					Evict(victimID);
+				}
+
+				texture.PendingMip = mip;
+				m_usage.Pending += mipSize;
+				commands.emplace_back(CommandType::Load, ID, mip);
+			}
+
+			return commands;
+		}
+
+		uint32_t GetResidentMip(TextureID ID) const { return GetTexture(ID).ResidentMip; }
+
+		void SetBudget(size_t budget) noexcept { m_budget = budget; }
+		size_t GetBudget() const noexcept { return m_budget; }
+
+		const Usage& GetUsage() const noexcept { return m_usage; }
+
+	private:
+		static constexpr uint32_t NoMip = ~0u;
+		static constexpr TextureID NoTexture = ~0u;
+
+		struct Texture {
+			bool IsRegistered{};
+			vector<size_t> MipSizes;
+			uint32_t TailMip{}, ResidentMip{}, RequestedMip{}, PendingMip = NoMip;
+			uint64_t LastRequestFrame = ~0ull;
+		};
+		vector<Texture> m_textures;
+		vector<TextureID> m_freeIDs;
+
+		size_t m_budget;
+		Usage m_usage{};
+
+		Texture& GetTexture(TextureID ID) {
+			if (ID >= size(m_textures) || !m_textures[ID].IsRegistered) {
+				Throw<out_of_range>("Texture is not registered");
+			}
+			return m_textures[ID];
+		}
+
+		const Texture& GetTexture(TextureID ID) const { return const_cast<TextureResidencyManager&>(*this).GetTexture(ID); }
+
+		/*
+		 * Prefers the texture holding the most memory beyond what it was last asked for,
+		 * then the least recently requested texture that was not requested in this frame.
+		 * Neither the texture being loaded for nor textures with a load in flight are chosen.
+		 */
+		TextureID FindEvictionVictim(TextureID loadingID, uint64_t frame) const {
+			auto victimID = NoTexture;
+			size_t maxSurplus = 0;
+			auto oldestFrame = frame;
+			auto oldestID = NoTexture;
+			for (TextureID ID = 0; const auto & texture : m_textures) {
+				if (texture.IsRegistered && ID != loadingID && texture.PendingMip == NoMip && texture.ResidentMip < texture.TailMip) {
+					if (texture.ResidentMip < texture.RequestedMip) {
+						if (const auto surplus = texture.MipSizes[texture.ResidentMip]; surplus > maxSurplus) {
+							maxSurplus = surplus;
+							victimID = ID;
+						}
+					}
+					else if (texture.LastRequestFrame != ~0ull && texture.LastRequestFrame < oldestFrame) {
+						oldestFrame = texture.LastRequestFrame;
+						oldestID = ID;
+					}
+				}
+				ID++;
+			}
+			return victimID != NoTexture ? victimID : oldestID;
+		}
+	};
+
+	struct TextureStreamingDesc {
+		bool IsEnabled{};
+
+		// Video memory that streamed textures may take, tails included; finer mips are evicted to stay within it
+		size_t Budget = size_t{ 1024 } << 20;
+
+		// Mips that fit in this many bytes, coarsest first, are uploaded with their model; finer ones are streamed in over the next frames
+		size_t TailSize = 64 * 1024;
+
+		// Mips uploaded per frame
+		size_t MaxLoadCount = 8;
+	};
+
+	/*
+	 * Uploads the tail of 2D textures at load and their finer mips over the following frames, in the order TextureResidencyManager issues them.
+	 * A texture only allocates the mips it has: each load or eviction moves it onto a new resource holding them, copied on the GPU,
+	 * and swaps it into the Texture that models hold, so that evicted mips give their memory back.
+	 * Mips finer than the tail are kept in a temporary file rather than in memory, and read back from it whenever they are uploaded again.
+	 * The mips to keep follow RequestMip, which the scene calls every frame with how large its textures appear on screen.
+	 */
+	class TextureStreamer {
+	public:
+		// Mips of a streamed texture, described by their allocation sizes, those finer than its tail being kept in File
+		struct StreamedMips {
+			DXGI_FORMAT Format;
+			UINT Width, Height;
+			vector<size_t> Sizes;
+			uint32_t TailMipCount;
+			shared_ptr<const MemoryMappedFile> File;
+			vector<D3D12_SUBRESOURCE_DATA> SubresourceData;
+		};
+
+		struct PendingTexture {
+			shared_ptr<Texture> Texture;
+			StreamedMips Mips;
+		};
+
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		explicit TextureStreamer(const TextureStreamingDesc& desc = {}) : m_desc(desc), m_residencyManager(desc.Budget) {}
+
+		const TextureStreamingDesc& GetDesc() const noexcept { return m_desc; }
+
+		// Thread-safe; mips beyond the new budget are evicted by the next Update
+		void SetBudget(size_t budget) {
+			const scoped_lock lock(m_mutex);
+
+			m_desc.Budget = budget;
+			m_residencyManager.SetBudget(budget);
+		}
+
+		/*
+		 * Records the upload of the tail mips of a single 2D image, nullopt if it is of another kind or has no mip beyond its tail.
+		 * A block-compressed texture never starts from a mip whose size is not a multiple of a block, so such mips go to the tail.
+		 * The result is handed to Add once the command list has finished, as until then the texture belongs to it; image is not needed once this returns.
+		 */
+		optional<PendingTexture> LoadTail(CommandList& commandList, const ScratchImage& image) const {
+			const auto& metadata = image.GetMetadata();
+			if (metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.IsCubemap()) {
+				return nullopt;
+			}
+
+			const auto& deviceContext = commandList.GetDeviceContext();
+
+			StreamedMips mips{
+				.Format = metadata.format,
+				.Width = static_cast<UINT>(metadata.width),
+				.Height = static_cast<UINT>(metadata.height)
+			};
+			const auto mipCount = static_cast<uint32_t>(metadata.mipLevels);
+
+			// Each mip costs what a resource starting from it takes over one starting from the next mip
+			mips.Sizes.resize(mipCount);
+			vector<size_t> resourceSizes(mipCount + 1);
+			for (uint32_t mip = 0; mip < mipCount; mip++) {
+				const auto desc = GetResourceDesc(mips, mipCount, mip);
+				resourceSizes[mip] = deviceContext.Device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+			}
+			for (uint32_t mip = 0; mip < mipCount; mip++) {
+				mips.Sizes[mip] = resourceSizes[mip] > resourceSizes[mip + 1] ? resourceSizes[mip] - resourceSizes[mip + 1] : 0;
+			}
+
+			auto tailMip = mipCount - TextureResidencyManager::GetTailMipCount(mips.Sizes, m_desc.TailSize);
+			if (IsCompressed(metadata.format)) {
+				for (uint32_t mip = 1; mip <= tailMip; mip++) {
+					if (max(mips.Width >> mip, 1u) % 4 || max(mips.Height >> mip, 1u) % 4) {
+						tailMip = mip - 1;
+						break;
+					}
+				}
+			}
+			if (!tailMip) {
+				return nullopt;
+			}
+			mips.TailMipCount = mipCount - tailMip;
+
+			vector<D3D12_SUBRESOURCE_DATA> subresourceData(mipCount);
+			vector<span<const std::byte>> streamedData(tailMip);
+			for (uint32_t mip = 0; mip < mipCount; mip++) {
+				const auto& mipImage = *image.GetImage(mip, 0, 0);
+				subresourceData[mip] = {
+					.pData = mipImage.pixels,
+					.RowPitch = static_cast<LONG_PTR>(mipImage.rowPitch),
+					.SlicePitch = static_cast<LONG_PTR>(mipImage.slicePitch)
+				};
+				if (mip < tailMip) {
+					streamedData[mip] = { reinterpret_cast<const std::byte*>(mipImage.pixels), mipImage.slicePitch };
+				}
+			}
+
+			const auto texture = make_shared<Texture>(deviceContext, GetCreationDesc(mips, tailMip));
+			commandList.Copy(*texture, span(subresourceData).subspan(tailMip), 0);
+			commandList.SetState(*texture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+			texture->CreateSRV(true);
+
+			mips.File = make_shared<const MemoryMappedFile>(streamedData);
+			mips.SubresourceData.resize(tailMip);
+			auto pData = data(mips.File->GetData());
+			for (uint32_t mip = 0; mip < tailMip; mip++) {
+				mips.SubresourceData[mip] = subresourceData[mip];
+				mips.SubresourceData[mip].pData = pData;
+				pData += size(streamedData[mip]);
+			}
+
+			return PendingTexture{ texture, move(mips) };
+		}
+
+		// Thread-safe
+		void Add(PendingTexture&& texture) {
+			const scoped_lock lock(m_mutex);
+
+			const auto ID = m_residencyManager.Register(texture.Mips.Sizes, texture.Mips.TailMipCount);
+			m_IDs[texture.Texture.get()] = ID;
+			const auto tailMip = static_cast<uint32_t>(size(texture.Mips.Sizes)) - texture.Mips.TailMipCount;
+			m_textures.try_emplace(ID, texture.Texture, texture.Texture.get(), move(texture.Mips), tailMip);
+		}
+
+		/*
+		 * Reports that texture spans size pixels on screen in the frame that the next Update prepares, which asks for the mip about that large.
+		 * Textures not streamed are ignored. Thread-safe.
+		 */
+		void RequestMip(const Texture& texture, float size) {
+			const scoped_lock lock(m_mutex);
+
+			const auto pID = m_IDs.find(&texture);
+			if (pID == cend(m_IDs)) {
+				return;
+			}
+			const auto& mips = m_textures.at(pID->second).Mips;
+			const auto texelCount = static_cast<float>(max(mips.Width, mips.Height));
+			const auto mip = size < texelCount ? static_cast<uint32_t>(log2(texelCount / max(size, 1.0f))) : 0;
+			m_residencyManager.RequestMip(pID->second, mip, m_frame);
+		}
+
+		/*
+		 * Records the loads and evictions of this frame, moving each texture they affect onto a resource with its new mips;
+		 * runs on the render thread between frames, before object data picks up the new descriptors.
+		 */
+		void Update(CommandList& commandList) {
+			const scoped_lock lock(m_mutex);
+
+			const auto frame = m_frame++;
+			auto& retiredTextures = m_retiredTextures[frame % size(m_retiredTextures)];
+			retiredTextures.clear();
+
+			for (auto pTexture = begin(m_textures); pTexture != end(m_textures);) {
+				if (const auto& [ID, streamedTexture] = *pTexture; streamedTexture.Texture.expired()) {
+					m_residencyManager.Unregister(ID);
+					// Another texture may have been added at the same address since
+					if (const auto pID = m_IDs.find(streamedTexture.Address); pID != cend(m_IDs) && pID->second == ID) {
+						m_IDs.erase(pID);
+					}
+					pTexture = m_textures.erase(pTexture);
+					continue;
+				}
+				++pTexture;
+			}
+
+			vector<TextureResidencyManager::TextureID> IDs;
+			for (const auto& [Type, ID, Mip] : m_residencyManager.Update(frame, m_desc.MaxLoadCount)) {
+				// Uploaded below, ahead of every draw of the frame on the same command list
+				if (Type == TextureResidencyManager::CommandType::Load) {
+					m_residencyManager.OnLoaded(ID, Mip);
+				}
+				if (!ranges::contains(IDs, ID)) {
+					IDs.emplace_back(ID);
+				}
+			}
+			for (const auto ID : IDs) {
+				if (auto texture = Reallocate(commandList, m_textures.at(ID), m_residencyManager.GetResidentMip(ID))) {
+					retiredTextures.emplace_back(move(texture));
+				}
+			}
+		}
+
+	private:
+		// Frames that may still read a replaced resource, at most one per back buffer
+		static constexpr size_t MaxFramesInFlight = 3;
+
+		struct StreamedTexture {
+			weak_ptr<Texture> Texture;
+			// Key of the texture in m_IDs, which outlives it
+			const DirectX::Texture* Address;
+			StreamedMips Mips;
+
+			// Most detailed mip of the resource
+			uint32_t FirstMip;
+		};
+
+		TextureStreamingDesc m_desc;
+
+		mutex m_mutex;
+		TextureResidencyManager m_residencyManager;
+		unordered_map<TextureResidencyManager::TextureID, StreamedTexture> m_textures;
+		unordered_map<const Texture*, TextureResidencyManager::TextureID> m_IDs;
+
+		uint64_t m_frame{};
+		vector<unique_ptr<Texture>> m_retiredTextures[MaxFramesInFlight + 1];
+
+		static D3D12_RESOURCE_DESC GetResourceDesc(const StreamedMips& mips, uint32_t mipCount, uint32_t firstMip) {
+			return CD3DX12_RESOURCE_DESC::Tex2D(mips.Format, max(mips.Width >> firstMip, 1u), max(mips.Height >> firstMip, 1u), 1, static_cast<UINT16>(mipCount - firstMip));
+		}
+
+		static Texture::CreationDesc GetCreationDesc(const StreamedMips& mips, uint32_t firstMip) {
+			const auto desc = GetResourceDesc(mips, static_cast<uint32_t>(size(mips.Sizes)), firstMip);
+			return {
+				.Format = desc.Format,
+				.Width = static_cast<UINT>(desc.Width),
+				.Height = desc.Height,
+				.MipLevels = desc.MipLevels
+			};
+		}
+
+		/*
+		 * Moves the texture onto a resource starting from firstMip, returning the previous one, which frames in flight may still read.
+		 * Nothing is done for a texture released since Update checked it, which the next Update unregisters.
+		 */
+		static unique_ptr<Texture> Reallocate(CommandList& commandList, StreamedTexture& streamedTexture, uint32_t firstMip) {
+			const auto texture = streamedTexture.Texture.lock();
+			if (!texture) {
+				return nullptr;
+			}
+			auto& [_1, _2, Mips, FirstMip] = streamedTexture;
+
+			auto newTexture = make_unique<Texture>(commandList.GetDeviceContext(), GetCreationDesc(Mips, firstMip));
+			for (auto mip = max(firstMip, FirstMip); mip < size(Mips.Sizes); mip++) {
+				commandList.Copy(*newTexture, mip - firstMip, *texture, mip - FirstMip);
+			}
+			if (firstMip < FirstMip) {
+				commandList.Copy(*newTexture, span(Mips.SubresourceData).subspan(firstMip, FirstMip - firstMip), 0);
+			}
+			commandList.SetState(*newTexture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+			newTexture->CreateSRV(true);
+
+			texture->Swap(*newTexture);
+			FirstMip = firstMip;
+			return newTexture;
+		}
+	};
+}
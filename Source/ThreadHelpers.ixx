@@ -1,26 +1,74 @@
 module;
 
+#include <algorithm>
+#include <atomic>
 #include <future>
+#include <memory>
+#include <vector>
 
 export module ThreadHelpers;
 
+export import ThreadPool;
+
 using namespace std;
 
 export namespace ThreadHelpers {
+	// Runs the function on the shared thread pool; the returned future also carries its exception
 	template <typename Function, typename... Args>
 	auto StartDetachedFuture(Function&& function, Args&&... args) {
-		using ResultType = invoke_result_t<Function, Args...>;
-		promise<ResultType> promise;
-		auto future = promise.get_future();
-		thread([function, ...args = forward<Args>(args), promise = move(promise)]() mutable {
-			if constexpr (is_same_v<ResultType, void>) {
-				function(forward<Args>(args)...);
-				promise.set_value();
+		return ThreadPool::GetDefault().Submit(
+			[function = forward<Function>(function), ...args = forward<Args>(args)]() mutable { return function(forward<Args>(args)...); }
+		);
+	}
+
+	/*
+	 * Runs function(index) for every index in [0, count) on the shared thread pool and rethrows the first exception in index order.
+	 * The calling thread takes indices as well, and then only waits for the indices that other threads have taken:
+	 * it never runs unrelated queued tasks, which could block on work further down its own stack, such as a cache entry it is producing,
+	 * and never waits for tasks that have not started, so that calls from pool tasks cannot starve either.
+	 */
+	template <typename Function>
+	void ParallelFor(size_t count, Function&& function) {
+		if (!count) {
+			return;
+		}
+
+		// Shared with the tasks, which may only start once every index is done; they then return without touching function
+		struct State {
+			atomic_size_t NextIndex, CompletedCount;
+			vector<exception_ptr> Exceptions;
+		};
+		const auto state = make_shared<State>();
+		state->Exceptions.resize(count);
+
+		const auto Run = [state, count, &function] {
+			for (size_t index; (index = state->NextIndex++) < count;) {
+				try {
+					function(index);
+				}
+				catch (...) {
+					state->Exceptions[index] = current_exception();
+				}
+
+				if (++state->CompletedCount == count) {
+					state->CompletedCount.notify_all();
+				}
 			}
-			else {
-				promise.set_value(function(forward<Args>(args)...));
+		};
+
+		auto& threadPool = ThreadPool::GetDefault();
+		for (size_t i = 1; i < min(count, threadPool.GetThreadCount()); i++) {
+			threadPool.Post(Run);
+		}
+		Run();
+		for (size_t completedCount; (completedCount = state->CompletedCount) != count;) {
+			state->CompletedCount.wait(completedCount);
+		}
+
+		for (const auto& exception : state->Exceptions) {
+			if (exception) {
+				rethrow_exception(exception);
 			}
-		}).detach();
-		return future;
+		}
 	}
 }
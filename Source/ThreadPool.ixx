@@ -0,0 +1,190 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+export module ThreadPool;
+
+using namespace std;
+
+export namespace ThreadHelpers {
+	/*
+	 * Fixed set of workers sized to the hardware, each owning a task deque.
+	 * A worker runs its newest task first and steals the oldest task of another worker once its own deque is empty,
+	 * while tasks submitted from other threads are dealt round-robin.
+	 * Threads waiting in Wait run queued tasks meanwhile, so tasks can wait for tasks they submit.
+	 * Any queued task may run that way, so Wait is only for threads that hold nothing that other tasks block on:
+	 * a task producing a shared cache entry must not call it, as it could pick up a task waiting for that very entry.
+	 */
+	class ThreadPool {
+	public:
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		explicit ThreadPool(size_t threadCount = max(thread::hardware_concurrency(), 1u)) {
+			m_queues.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; i++) {
+				m_queues.emplace_back(make_unique<Queue>());
+			}
+
+			m_threads.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; i++) {
+				m_threads.emplace_back([this, i] { Run(i); });
+			}
+		}
+
+		~ThreadPool() {
+			{
+				const scoped_lock lock(m_mutex);
+
+				m_isStopping = true;
+			}
+			m_condition.notify_all();
+
+			m_threads.clear();
+		}
+
+		// Never destroyed, so that tasks still running at exit do not hold it up, as with detached threads
+		static ThreadPool& GetDefault() {
+			static auto& threadPool = *new ThreadPool;
+			return threadPool;
+		}
+
+		size_t GetThreadCount() const noexcept { return size(m_threads); }
+
+		template <typename Function>
+		auto Submit(Function&& function) {
+			packaged_task<invoke_result_t<decay_t<Function>&>()> task(forward<Function>(function));
+			auto future = task.get_future();
+			Push(move(task));
+			return future;
+		}
+
+		// For tasks whose results nobody waits for
+		template <typename Function>
+		void Post(Function&& function) { Push(Task(forward<Function>(function))); }
+
+		template <typename T>
+		void Wait(const future<T>& future) { WaitUntilReady(future); }
+
+		template <typename T>
+		void Wait(const shared_future<T>& future) { WaitUntilReady(future); }
+
+		template <typename T>
+		void Wait(const vector<future<T>>& futures) {
+			for (const auto& future : futures) {
+				Wait(future);
+			}
+		}
+
+	private:
+		using Task = move_only_function<void()>;
+
+		struct Queue {
+			mutex Mutex;
+			deque<Task> Tasks;
+		};
+		vector<unique_ptr<Queue>> m_queues;
+
+		atomic_size_t m_nextQueueIndex{}, m_taskCount{};
+
+		mutex m_mutex;
+		condition_variable m_condition;
+		bool m_isStopping{};
+
+		vector<jthread> m_threads;
+
+		static pair<const ThreadPool*, size_t>& GetCurrentWorker() {
+			static thread_local pair<const ThreadPool*, size_t> worker{ nullptr, 0 };
+			return worker;
+		}
+
+		template <typename Future>
+		void WaitUntilReady(const Future& future) {
+			const auto& [threadPool, index] = GetCurrentWorker();
+			const auto queueIndex = threadPool == this ? index : 0;
+			while (future.wait_for(0s) != future_status::ready) {
+				if (!RunOne(queueIndex)) {
+					future.wait_for(1ms);
+				}
+			}
+		}
+
+		void Push(Task&& task) {
+			{
+				// Counted before the task is visible, so that Pop never takes the count below zero,
+				// and under the lock, so that a worker about to sleep cannot miss it
+				const scoped_lock lock(m_mutex);
+
+				m_taskCount++;
+			}
+
+			const auto& [threadPool, index] = GetCurrentWorker();
+			auto& queue = *m_queues[threadPool == this ? index : m_nextQueueIndex++ % size(m_queues)];
+			{
+				const scoped_lock lock(queue.Mutex);
+
+				queue.Tasks.emplace_back(move(task));
+			}
+			m_condition.notify_one();
+		}
+
+		optional<Task> Pop(size_t queueIndex) {
+			for (size_t i = 0; i < size(m_queues); i++) {
+				auto& queue = *m_queues[(queueIndex + i) % size(m_queues)];
+
+				const scoped_lock lock(queue.Mutex);
+
+				if (!empty(queue.Tasks)) {
+					Task task;
+					if (i == 0) {
+						task = move(queue.Tasks.back());
+						queue.Tasks.pop_back();
+					}
+					else {
+						task = move(queue.Tasks.front());
+						queue.Tasks.pop_front();
+					}
+					m_taskCount--;
+					return task;
+				}
+			}
+			return nullopt;
+		}
+
+		bool RunOne(size_t queueIndex) {
+			auto task = Pop(queueIndex);
+			if (!task) {
+				return false;
+			}
+			(*task)();
+			return true;
+		}
+
+		void Run(size_t index) {
+			GetCurrentWorker() = { this, index };
+
+			while (true) {
+				if (RunOne(index)) {
+					continue;
+				}
+
+				unique_lock lock(m_mutex);
+
+				m_condition.wait(lock, [&] { return m_taskCount || m_isStopping; });
+				if (m_isStopping) {
+					return;
+				}
+			}
+		}
+	};
+}
@@ -1,5 +1,11 @@
 module;
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <numbers>
+
 #include <DirectXPackedVector.h>
 
 #include "ml.h"
@@ -12,6 +18,7 @@ using namespace DirectX;
 using namespace DirectX::PackedVector;
 using namespace Math;
 using namespace Packing;
+using namespace std;
 
 namespace {
 	auto EncodeUnitVector(const XMFLOAT3& value) {
@@ -24,17 +31,78 @@ namespace {
 	auto EncodeTextureCoordinate(XMFLOAT2 value) {
 		return reinterpret_cast<const XMHALF2&>(float2_to_float16_t2(reinterpret_cast<const float2&>(value)));
 	}
+
+	XMVECTOR DecodeUnitVector(const int16_t3& value) {
+		const auto components = reinterpret_cast<const int16_t*>(&value);
+		return XMVectorMax(XMVectorSet(components[0], components[1], components[2], 0) / 0x7fff, g_XMNegativeOne);
+	}
+
+	// Same as GetOrthonormalBasis in Vertex.hlsli
+	void GetOrthonormalBasis(FXMVECTOR normal, XMVECTOR& tangent, XMVECTOR& bitangent) {
+		const auto x = XMVectorGetX(normal), y = XMVectorGetY(normal), z = XMVectorGetZ(normal);
+		const auto sign = z >= 0 ? 1.0f : -1.0f, a = -1 / (sign + z), b = x * y * a;
+		tangent = XMVectorSet(1 + sign * x * x * a, sign * b, -sign * x, 0);
+		bitangent = XMVectorSet(b, sign + y * y * a, -y, 0);
+	}
 }
 
 export {
 	struct VertexDesc {
 		uint32_t Stride{};
-		XMUINT3 _;
+		XMFLOAT3 PositionScale{ 1, 1, 1 };
 		struct {
 			uint32_t Normal = ~0u, Tangent = ~0u, TextureCoordinates[2]{ ~0u, ~0u };
 		} AttributeOffsets;
+		XMFLOAT3 PositionOffset{};
+
+		// Compact vertices store positions as 16-bit SNORM, mapped to object space by PositionScale and PositionOffset,
+		// and normal and tangent as a single EncodeTangentFrame value at both attribute offsets
+		uint32_t IsCompact{};
 	};
 
+	/*
+	 * Packs an octahedral normal in 2x12 bits and the angle of the tangent around it in 8 bits,
+	 * the tangent being measured against the basis of the decoded normal so that the GPU rebuilds the same one.
+	 */
+	// Same as DecodeTangentFrameNormal in Vertex.hlsli
+	XMVECTOR DecodeTangentFrameNormal(uint32_t value) {
+		auto normal = XMVectorSet((value & 0xfff) / 4095.0f * 2 - 1, (value >> 12 & 0xfff) / 4095.0f * 2 - 1, 0, 0);
+		normal = XMVectorSetZ(normal, 1 - abs(XMVectorGetX(normal)) - abs(XMVectorGetY(normal)));
+		const auto t = max(-XMVectorGetZ(normal), 0.0f);
+		const auto offsets = XMVectorSelect(XMVectorReplicate(t), XMVectorReplicate(-t), XMVectorGreaterOrEqual(normal, XMVectorZero()));
+		return XMVector3Normalize(normal + XMVectorSelect(XMVectorZero(), offsets, g_XMSelect1100));
+	}
+
+	// Same as DecodeTangentFrameTangent in Vertex.hlsli
+	XMVECTOR DecodeTangentFrameTangent(uint32_t value) {
+		XMVECTOR tangent, bitangent;
+		GetOrthonormalBasis(DecodeTangentFrameNormal(value), tangent, bitangent);
+		const auto radians = static_cast<float>(value >> 24) * (2 * numbers::pi_v<float> / 256);
+		return cos(radians) * tangent + sin(radians) * bitangent;
+	}
+
+	uint32_t EncodeTangentFrame(const int16_t3& normal, const int16_t3* tangent = nullptr) {
+		auto octahedron = DecodeUnitVector(normal);
+		octahedron /= XMVectorGetX(XMVectorSum(XMVectorAbs(octahedron)));
+		if (XMVectorGetZ(octahedron) < 0) {
+			const auto signs = XMVectorSelect(g_XMNegativeOne, g_XMOne, XMVectorGreaterOrEqual(octahedron, XMVectorZero()));
+			octahedron = (g_XMOne - XMVectorAbs(XMVectorSwizzle<XM_SWIZZLE_Y, XM_SWIZZLE_X, XM_SWIZZLE_Z, XM_SWIZZLE_W>(octahedron))) * signs;
+		}
+		const auto quantized = XMVectorRound(XMVectorSaturate(XMVectorMultiplyAdd(octahedron, g_XMOneHalf, g_XMOneHalf)) * 0xfff);
+		const auto u = static_cast<uint32_t>(XMVectorGetX(quantized)), v = static_cast<uint32_t>(XMVectorGetY(quantized));
+
+		uint32_t angle = 0;
+		if (tangent != nullptr) {
+			XMVECTOR basisTangent, basisBitangent;
+			GetOrthonormalBasis(DecodeTangentFrameNormal(u | v << 12), basisTangent, basisBitangent);
+			const auto _tangent = DecodeUnitVector(*tangent);
+			const auto radians = atan2(XMVectorGetX(XMVector3Dot(_tangent, basisBitangent)), XMVectorGetX(XMVector3Dot(_tangent, basisTangent)));
+			angle = static_cast<uint32_t>(lround(radians / (2 * numbers::pi_v<float>) * 256)) & 0xff;
+		}
+
+		return u | v << 12 | angle << 24;
+	}
+
 	struct VertexPositionNormalTangentTexture {
 		XMFLOAT3 Position;
 		int16_t3 Normal, Tangent;
@@ -55,4 +123,75 @@ export {
 		XMUSHORT4 Joints;
 		XMFLOAT4 Weights;
 	};
+
+	/*
+	 * Skinned vertices as uploaded: the rest pose of VertexPositionNormalTangentSkin,
+	 * followed by 8-bit or 16-bit joint indices and UNORM8 or UNORM16 weights that sum to exactly one.
+	 */
+	struct SkinDesc {
+		static constexpr uint32_t JointsOffset = offsetof(VertexPositionNormalTangentSkin, Joints);
+
+		// Weights use UNORM8 when no vertex moves any of them by more than one of its steps
+		static constexpr float Max8BitWeightError = 1.0f / UINT8_MAX;
+
+		uint32_t Stride{}, WeightsOffset{}, Has8BitJoints{}, Has8BitWeights{};
+
+		SkinDesc() = default;
+
+		SkinDesc(bool has8BitJoints, bool has8BitWeights) :
+			Stride(JointsOffset + (has8BitJoints ? sizeof(XMUBYTE4) : sizeof(XMUSHORT4)) + (has8BitWeights ? sizeof(XMUBYTEN4) : sizeof(XMUSHORTN4))),
+			WeightsOffset(JointsOffset + (has8BitJoints ? sizeof(XMUBYTE4) : sizeof(XMUSHORT4))),
+			Has8BitJoints(has8BitJoints), Has8BitWeights(has8BitWeights) {}
+
+		// The largest weight takes the rounding error, so that weights still sum to one
+		static void QuantizeWeights(const XMFLOAT4& weights, bool has8BitWeights, int32_t(&quantizedWeights)[4]) {
+			const auto maxWeight = has8BitWeights ? UINT8_MAX : UINT16_MAX;
+			int32_t sum = 0;
+			for (size_t i = 0; const auto weight : { weights.x, weights.y, weights.z, weights.w }) {
+				quantizedWeights[i] = static_cast<int32_t>(lround(clamp(weight, 0.0f, 1.0f) * maxWeight));
+				sum += quantizedWeights[i++];
+			}
+			if (sum) {
+				*ranges::max_element(quantizedWeights) += maxWeight - sum;
+			}
+		}
+
+		// Largest difference between a weight and its quantized value
+		static float GetWeightError(const XMFLOAT4& weights, bool has8BitWeights) {
+			const auto maxWeight = static_cast<float>(has8BitWeights ? UINT8_MAX : UINT16_MAX);
+			int32_t quantizedWeights[4];
+			QuantizeWeights(weights, has8BitWeights, quantizedWeights);
+			float error = 0;
+			for (size_t i = 0; const auto weight : { weights.x, weights.y, weights.z, weights.w }) {
+				error = max(error, abs(static_cast<float>(quantizedWeights[i++]) / maxWeight - clamp(weight, 0.0f, 1.0f)));
+			}
+			return error;
+		}
+
+		void Encode(const VertexPositionNormalTangentSkin& vertex, void* destination) const {
+			const auto pDestination = static_cast<uint8_t*>(destination);
+			memcpy(pDestination, &vertex, JointsOffset);
+
+			const auto joints = reinterpret_cast<const uint16_t*>(&vertex.Joints);
+
+			int32_t quantizedWeights[4];
+			QuantizeWeights(vertex.Weights, Has8BitWeights, quantizedWeights);
+
+			for (size_t i = 0; i < 4; i++) {
+				if (Has8BitJoints) {
+					pDestination[JointsOffset + i] = static_cast<uint8_t>(joints[i]);
+				}
+				else {
+					reinterpret_cast<uint16_t*>(pDestination + JointsOffset)[i] = joints[i];
+				}
+
+				if (Has8BitWeights) {
+					pDestination[WeightsOffset + i] = static_cast<uint8_t>(quantizedWeights[i]);
+				}
+				else {
+					reinterpret_cast<uint16_t*>(pDestination + WeightsOffset)[i] = static_cast<uint16_t>(quantizedWeights[i]);
+				}
+			}
+		}
+	};
 }
@@ -0,0 +1,109 @@
+module;
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <ostream>
+#include <span>
+
+#include <DirectXPackedVector.h>
+
+#include "directx/d3d12.h"
+
+export module CompactVertexBenchmark;
+
+import GLTFHelpers;
+import Vertex;
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+	/*
+	 * Positions are off by at most half a 16-bit step of the half extent of their mesh per axis, well within a 16-bit step of its diagonal.
+	 * Normals are stored as 2x12-bit octahedral coordinates, about 0.02 degrees apart, and tangent angles in steps of 1.4 degrees.
+	 */
+	constexpr float MaxRelativePositionError = 1.0f / 0x7fff, MaxNormalError = 0.1f, MaxTangentError = 1;
+}
+
+/*
+ * Round-trips the vertices of each model through the compact layout of CreateMesh and prints the largest errors it introduces:
+ * positions in object space units and relative to the size of their mesh, normals and tangents in degrees.
+ * Tangents are compared with their source made orthogonal to the source normal, since the tangent frame cannot hold anything else.
+ * Skinned meshes keep the full layout and are skipped.
+ * Returns whether every error stays within what the quantization of each attribute allows.
+ */
+export bool BenchmarkCompactVertices(span<const path> filePaths, ostream& outputStream) {
+	auto isPassed = true;
+	const auto DecodeUnitVector = [](const auto& value) {
+		const auto components = reinterpret_cast<const int16_t*>(&value);
+		return XMVector3Normalize(XMVectorMax(XMVectorSet(components[0], components[1], components[2], 0) / 0x7fff, g_XMNegativeOne));
+	};
+	const auto GetAngle = [](FXMVECTOR a, FXMVECTOR b) {
+		return XMConvertToDegrees(acos(clamp(XMVectorGetX(XMVector3Dot(a, b)), -1.0f, 1.0f)));
+	};
+
+	for (const auto& filePath : filePaths) {
+		ModelData modelData;
+		GLTFHelpers::DecodeModel(modelData, filePath);
+
+		size_t vertexCount = 0, normalCount = 0, tangentCount = 0;
+		float maxPositionError = 0, maxRelativePositionError = 0, maxNormalError = 0, maxTangentError = 0;
+		for (const auto& meshNode : modelData.MeshNodes) {
+			for (const auto& meshData : meshNode.Meshes) {
+				if (!empty(meshData.SkeletalVertices) || empty(meshData.Vertices)) {
+					continue;
+				}
+
+				// Same bounds as CreateMesh
+				auto minPosition = XMVectorReplicate(FLT_MAX), maxPosition = XMVectorReplicate(-FLT_MAX);
+				for (const auto& vertex : meshData.Vertices) {
+					const auto position = XMLoadFloat3(&vertex.Position);
+					minPosition = XMVectorMin(minPosition, position);
+					maxPosition = XMVectorMax(maxPosition, position);
+				}
+				const auto offset = (minPosition + maxPosition) * 0.5f, scale = XMVectorMax((maxPosition - minPosition) * 0.5f, XMVectorReplicate(FLT_MIN));
+				const auto extent = max(XMVectorGetX(XMVector3Length(maxPosition - minPosition)), FLT_MIN);
+
+				for (const auto& vertex : meshData.Vertices) {
+					const auto position = XMLoadFloat3(&vertex.Position);
+					XMSHORTN4 compactPosition;
+					XMStoreShortN4(&compactPosition, XMVectorSetW((position - offset) / scale, 0));
+					const auto positionError = XMVectorGetX(XMVector3Length(XMVectorMultiplyAdd(XMLoadShortN4(&compactPosition), scale, offset) - position));
+					maxPositionError = max(maxPositionError, positionError);
+					maxRelativePositionError = max(maxRelativePositionError, positionError / extent);
+
+					if (meshData.HasNormals) {
+						const auto tangentFrame = EncodeTangentFrame(vertex.Normal, meshData.HasTangents ? &vertex.Tangent : nullptr);
+						const auto normal = DecodeUnitVector(vertex.Normal);
+						maxNormalError = max(maxNormalError, GetAngle(DecodeTangentFrameNormal(tangentFrame), normal));
+						normalCount++;
+
+						if (meshData.HasTangents) {
+							const auto tangent = DecodeUnitVector(vertex.Tangent);
+							if (const auto orthogonalTangent = tangent - normal * XMVector3Dot(normal, tangent);
+								XMVectorGetX(XMVector3LengthSq(orthogonalTangent)) > 1e-6f) {
+								maxTangentError = max(maxTangentError, GetAngle(DecodeTangentFrameTangent(tangentFrame), XMVector3Normalize(orthogonalTangent)));
+								tangentCount++;
+							}
+						}
+					}
+				}
+				vertexCount += size(meshData.Vertices);
+			}
+		}
+
+		outputStream << format("{}: {} vertices, {} normals, {} tangents", filePath.string(), vertexCount, normalCount, tangentCount) << endl;
+		outputStream << format("  Max position error: {:.4g} ({:.4g} of the mesh diagonal)", maxPositionError, maxRelativePositionError) << endl;
+		outputStream << format("  Max normal error: {:.3f} degrees", maxNormalError) << endl;
+		outputStream << format("  Max tangent error: {:.3f} degrees", maxTangentError) << endl;
+
+		const auto isWithinBounds = maxRelativePositionError <= MaxRelativePositionError && maxNormalError <= MaxNormalError && maxTangentError <= MaxTangentError;
+		outputStream << format("  Within bounds: {}", isWithinBounds ? "passed" : "FAILED") << endl;
+		isPassed &= isWithinBounds;
+	}
+	return isPassed;
+}
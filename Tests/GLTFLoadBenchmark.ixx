@@ -0,0 +1,115 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string>
+
+#include <Windows.h>
+#include <Psapi.h>
+
+export module GLTFLoadBenchmark;
+
+import ErrorHelpers;
+import GLTFHelpers;
+
+using namespace ErrorHelpers;
+using namespace std;
+using namespace std::chrono;
+using namespace std::filesystem;
+
+namespace {
+	size_t GetPeakWorkingSetSize() {
+		PROCESS_MEMORY_COUNTERS counters{ .cb = sizeof(counters) };
+		ThrowIfFailed(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)));
+		return counters.PeakWorkingSetSize;
+	}
+
+	bool IsEqual(const ModelData& a, const ModelData& b) {
+		return ranges::equal(a.MeshNodes, b.MeshNodes, [](const MeshNodeData& a, const MeshNodeData& b) {
+			return ranges::equal(a.Meshes, b.Meshes, [](const MeshData& a, const MeshData& b) {
+				return a.IndexFormat == b.IndexFormat && a.Indices == b.Indices
+					&& ranges::equal(as_bytes(span(a.Vertices)), as_bytes(span(b.Vertices)))
+					&& ranges::equal(as_bytes(span(a.SkeletalVertices)), as_bytes(span(b.SkeletalVertices)));
+			});
+		});
+	}
+}
+
+/*
+ * Decodes the model once, either reading it and its buffers into memory, as loads did before buffers were mapped, or mapping them.
+ * Prints the wall time and the peak working set of the process, in total and over what it was before the load.
+ * The peak never goes down, so each path needs a process of its own: BenchmarkGLTFLoad runs this one in child processes.
+ */
+export void MeasureGLTFLoad(const path& filePath, bool isMemoryMapped, ostream& outputStream) {
+	const auto startPeakWorkingSetSize = GetPeakWorkingSetSize();
+
+	const auto startTime = steady_clock::now();
+	ModelData modelData;
+	GLTFHelpers::DecodeModel(modelData, *GLTFHelpers::ParseModel(filePath, isMemoryMapped));
+	const duration<double, milli> elapsed = steady_clock::now() - startTime;
+
+	const auto peakWorkingSetSize = GetPeakWorkingSetSize();
+	const auto ToMiB = [](size_t size) { return static_cast<double>(size) / (1 << 20); };
+	outputStream << format(
+		"  {}: {:.1f} ms, peak working set {:.1f} MiB (+{:.1f} MiB)",
+		isMemoryMapped ? "Mapped" : "Read", elapsed.count(), ToMiB(peakWorkingSetSize), ToMiB(peakWorkingSetSize - startPeakWorkingSetSize)
+	) << endl;
+}
+
+/*
+ * Runs MeasureGLTFLoad for each model and path in a child process of this executable, which prints to the same console.
+ * The model is decoded with both paths beforehand, so that both start from a warm file cache.
+ * Returns whether both paths decoded the same meshes and every child process succeeded.
+ */
+export bool BenchmarkGLTFLoad(span<const path> filePaths, ostream& outputStream) {
+	wstring modulePath(MAX_PATH, 0);
+	for (;;) {
+		const auto length = GetModuleFileNameW(nullptr, data(modulePath), static_cast<DWORD>(size(modulePath)));
+		ThrowIfFailed(static_cast<BOOL>(length != 0));
+		if (length < size(modulePath)) {
+			modulePath.resize(length);
+			break;
+		}
+		modulePath.resize(size(modulePath) * 2);
+	}
+
+	auto isPassed = true;
+	for (const auto& filePath : filePaths) {
+		outputStream << filePath.string() << endl;
+
+		{
+			ModelData modelData[2];
+			for (const auto isMemoryMapped : { false, true }) {
+				GLTFHelpers::DecodeModel(modelData[isMemoryMapped], *GLTFHelpers::ParseModel(filePath, isMemoryMapped));
+			}
+			const auto isEqual = IsEqual(modelData[0], modelData[1]);
+			outputStream << format("  Mapped matches read: {}", isEqual ? "passed" : "FAILED") << endl;
+			isPassed &= isEqual;
+		}
+
+		for (const auto isMemoryMapped : { false, true }) {
+			auto commandLine = format(
+				L"\"{}\" gltf-load-child {} \"{}\"",
+				modulePath, isMemoryMapped ? L"mapped" : L"read", filePath.wstring()
+			);
+			STARTUPINFOW startupInfo{ .cb = sizeof(startupInfo) };
+			PROCESS_INFORMATION processInformation;
+			ThrowIfFailed(CreateProcessW(modulePath.c_str(), data(commandLine), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInformation));
+			CloseHandle(processInformation.hThread);
+			WaitForSingleObject(processInformation.hProcess, INFINITE);
+
+			DWORD exitCode;
+			const auto ret = GetExitCodeProcess(processInformation.hProcess, &exitCode);
+			CloseHandle(processInformation.hProcess);
+			ThrowIfFailed(ret);
+			if (exitCode != ERROR_SUCCESS) {
+				outputStream << format("  {}: failed with exit code {}", isMemoryMapped ? "Mapped" : "Read", exitCode) << endl;
+				isPassed = false;
+			}
+		}
+	}
+	return isPassed;
+}
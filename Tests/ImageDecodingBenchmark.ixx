@@ -0,0 +1,123 @@
+module;
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <thread>
+
+#include "directx/d3d12.h"
+
+#include "DirectXTex.h"
+
+#include "OpenEXR/ImfThreading.h"
+
+export module ImageDecodingBenchmark;
+
+import MemoryMappedFile;
+import TextureHelpers;
+
+using namespace DirectX;
+using namespace DirectX::TextureHelpers;
+using namespace std;
+using namespace std::chrono;
+using namespace std::filesystem;
+
+namespace {
+	constexpr auto MinDuration = 1s;
+	constexpr size_t MinIterationCount = 3;
+
+	// Decodes once to warm up, then repeatedly for at least MinDuration, returning the throughput in encoded megabytes per second
+	double Measure(size_t fileSize, const function<void()>& prepare, const function<void(ScratchImage&)>& decode) {
+		ScratchImage image;
+		decode(image);
+		prepare();
+
+		size_t iterationCount = 0;
+		const auto start = steady_clock::now();
+		duration<double> elapsed;
+		do {
+			decode(image);
+			iterationCount++;
+			elapsed = steady_clock::now() - start;
+		}
+		while (elapsed < MinDuration || iterationCount < MinIterationCount);
+
+		return static_cast<double>(fileSize) * iterationCount / elapsed.count() / 1e6;
+	}
+
+	bool IsEqual(const ScratchImage& a, const ScratchImage& b, bool comparePixels) {
+		const auto& metadataA = a.GetMetadata(), & metadataB = b.GetMetadata();
+		if (metadataA.width != metadataB.width || metadataA.height != metadataB.height || metadataA.format != metadataB.format) {
+			return false;
+		}
+		return !comparePixels || (a.GetPixelsSize() == b.GetPixelsSize() && !memcmp(a.GetPixels(), b.GetPixels(), a.GetPixelsSize()));
+	}
+}
+
+/*
+ * Prints the decode throughput of each image in MB/s of encoded data with the decoders that apply to its format:
+ * WIC and the portable decoders for PNG and JPEG images decoded from memory, OpenEXR with and without its thread pool for EXR files.
+ * Returns whether every decoder succeeded with the same size and format, and with the same pixels for all but JPEG images,
+ * whose decoders may round differently.
+ */
+export bool BenchmarkImageDecoding(span<const path> filePaths, ostream& outputStream) {
+	auto isPassed = true;
+	for (const auto& filePath : filePaths) {
+		const MemoryMappedFile file(filePath);
+		const vector data(cbegin(file.GetData()), cend(file.GetData()));
+		const auto fileSize = size(data);
+
+		const auto filePathExtension = filePath.extension().string();
+		const auto extension = empty(filePathExtension) ? string() : filePathExtension.substr(1);
+
+		struct Candidate {
+			string Name;
+			function<void()> Prepare;
+			function<void(ScratchImage&)> Decode;
+		};
+		vector<Candidate> candidates;
+		if (!_stricmp(extension.c_str(), "exr")) {
+			const auto threadCount = static_cast<int>(thread::hardware_concurrency());
+			const auto decode = [&](ScratchImage& image) { DecodeTexture(image, filePath); };
+			candidates = {
+				{ "OpenEXR, 1 thread", [] { Imf::setGlobalThreadCount(0); }, decode },
+				{ format("OpenEXR, {} threads", threadCount), [=] { Imf::setGlobalThreadCount(threadCount); }, decode }
+			};
+		}
+		else {
+			for (const auto [name, decoder] : { pair("WIC", ImageDecoder::WIC), pair("Portable", ImageDecoder::Portable) }) {
+				candidates.emplace_back(name, [] {}, [&, decoder](ScratchImage& image) { DecodeTexture(image, extension, data, false, decoder); });
+			}
+		}
+
+		const auto isLossless = _stricmp(extension.c_str(), "jpg") && _stricmp(extension.c_str(), "jpeg");
+
+		outputStream << format("{}: {:.2f} MB", filePath.string(), fileSize / 1e6) << endl;
+		auto isConsistent = true;
+		ScratchImage firstImage;
+		for (const auto& [Name, Prepare, Decode] : candidates) {
+			try {
+				ScratchImage image;
+				Decode(image);
+				if (!firstImage.GetImageCount()) {
+					firstImage = move(image);
+				}
+				else {
+					isConsistent &= IsEqual(firstImage, image, isLossless);
+				}
+
+				outputStream << format("  {}: {:.1f} MB/s", Name, Measure(fileSize, Prepare, Decode)) << endl;
+			}
+			catch (const exception& e) {
+				outputStream << format("  {}: {}", Name, e.what()) << endl;
+				isConsistent = false;
+			}
+		}
+		outputStream << format("  Decoders agree: {}", isConsistent ? "passed" : "FAILED") << endl;
+		isPassed &= isConsistent;
+	}
+	return isPassed;
+}
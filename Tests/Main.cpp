@@ -0,0 +1,80 @@
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <Windows.h>
+#include <roapi.h>
+
+import CompactVertexBenchmark;
+import ErrorHelpers;
+import GLTFLoadBenchmark;
+import ImageDecodingBenchmark;
+import MeshLODBenchmark;
+import ParallelForTest;
+import SceneDescBenchmark;
+import TextureKeyTest;
+import TextureStreamingBenchmark;
+import VertexFetchBenchmark;
+
+using namespace ErrorHelpers;
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+	struct Test {
+		wstring_view Name;
+		bool IsTakingFiles;
+		function<bool(span<const path>)> Run;
+	};
+	const Test g_tests[]{
+		{ L"parallel-for", false, [](span<const path>) { return TestParallelFor(cout); } },
+		{ L"scene-desc", false, [](span<const path>) { return BenchmarkSceneDesc(cout); } },
+		{ L"texture-key", false, [](span<const path>) { return TestTextureKey(cout); } },
+		{ L"texture-streaming", false, [](span<const path>) { return BenchmarkTextureStreaming(cout); } },
+		{ L"compact-vertices", true, [](span<const path> filePaths) { return BenchmarkCompactVertices(filePaths, cout); } },
+		{ L"gltf-load", true, [](span<const path> filePaths) { return BenchmarkGLTFLoad(filePaths, cout); } },
+		{ L"image-decoding", true, [](span<const path> filePaths) { return BenchmarkImageDecoding(filePaths, cout); } },
+		{ L"mesh-lods", true, [](span<const path> filePaths) { return BenchmarkMeshLODs(filePaths, cout); } },
+		{ L"vertex-fetch", true, [](span<const path> filePaths) { return BenchmarkVertexFetch(filePaths, cout); } }
+	};
+}
+
+/*
+ * PhysicallyBasedRaytracerTests <Test> [<File>...]
+ * Runs one test and exits with ERROR_SUCCESS if all of its checks held. Tests that take models or images need at least one;
+ * the others are self-contained and registered with CTest.
+ */
+int wmain(int argc, wchar_t* argv[]) {
+	try {
+		ThrowIfFailed(RoInitialize(RO_INIT_MULTITHREADED));
+
+		// Run by gltf-load: PhysicallyBasedRaytracerTests gltf-load-child <read|mapped> <Model>
+		if (argc == 4 && !_wcsicmp(argv[1], L"gltf-load-child")) {
+			MeasureGLTFLoad(argv[3], !_wcsicmp(argv[2], L"mapped"), cout);
+
+			return ERROR_SUCCESS;
+		}
+
+		if (argc >= 2) {
+			for (const auto& [Name, IsTakingFiles, Run] : g_tests) {
+				if (!_wcsicmp(argv[1], data(Name)) && (argc > 2) == IsTakingFiles) {
+					const vector<path> filePaths(argv + 2, argv + argc);
+					return Run(filePaths) ? ERROR_SUCCESS : ERROR_CAN_NOT_COMPLETE;
+				}
+			}
+		}
+
+		wcerr << L"Usage: PhysicallyBasedRaytracerTests <Test> [<File>...]" << endl;
+		for (const auto& [Name, IsTakingFiles, Run] : g_tests) {
+			wcerr << L"  " << Name << (IsTakingFiles ? L" <File>..." : L"") << endl;
+		}
+		return ERROR_BAD_ARGUMENTS;
+	}
+	catch (const exception& e) {
+		cerr << e.what() << endl;
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+}
@@ -0,0 +1,80 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "directx/d3d12.h"
+
+export module MeshLODBenchmark;
+
+import GLTFHelpers;
+import MeshOptimization;
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::filesystem;
+
+/*
+ * Prints, for each model, the time GenerateLODs takes over all of its meshes, then for each level the triangles left
+ * and the largest object space error of its meshes, which is what the LOD selection of Scene projects to pixels.
+ * Meshes with fewer levels count with their coarsest one at the levels they lack, as the selection uses it there.
+ * Returns whether every level of every model has no more triangles and no less error than the one before it.
+ */
+export bool BenchmarkMeshLODs(span<const path> filePaths, ostream& outputStream) {
+	auto isPassed = true;
+	for (const auto& filePath : filePaths) {
+		ModelData modelData;
+		GLTFHelpers::DecodeModel(modelData, filePath, false);
+
+		const auto startTime = steady_clock::now();
+		size_t levelCount = 1;
+		for (auto& meshNode : modelData.MeshNodes) {
+			for (auto& meshData : meshNode.Meshes) {
+				GenerateLODs(meshData, { .IsEnabled = true });
+				levelCount = max(levelCount, size(meshData.LODs) + 1);
+			}
+		}
+		const duration<double, milli> elapsed = steady_clock::now() - startTime;
+
+		struct Level {
+			size_t TriangleCount;
+			float MaxError;
+		};
+		vector<Level> levels(levelCount);
+		for (const auto& meshNode : modelData.MeshNodes) {
+			for (const auto& meshData : meshNode.Meshes) {
+				const auto indexStride = meshData.IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+				for (size_t i = 0; auto & [TriangleCount, MaxError] : levels) {
+					if (const auto LODIndex = min(i++, size(meshData.LODs)); LODIndex) {
+						const auto& LOD = meshData.LODs[LODIndex - 1];
+						TriangleCount += size(LOD.Indices) / indexStride / 3;
+						MaxError = max(MaxError, LOD.Error);
+					}
+					else {
+						TriangleCount += meshData.GetIndexCount() / 3;
+					}
+				}
+			}
+		}
+
+		outputStream << format("{}: {} levels generated in {:.1f} ms", filePath.string(), levelCount, elapsed.count()) << endl;
+		for (size_t i = 0; const auto & [TriangleCount, MaxError] : levels) {
+			outputStream << format(
+				"  LOD {}: {} triangles ({:.1f}%), max error {:.4g}",
+				i, TriangleCount, levels[0].TriangleCount ? 100.0 * TriangleCount / levels[0].TriangleCount : 0.0, MaxError
+			) << endl;
+			i++;
+		}
+
+		const auto isMonotonic = ranges::adjacent_find(levels, [](const Level& a, const Level& b) {
+			return b.TriangleCount > a.TriangleCount || b.MaxError < a.MaxError;
+		}) == cend(levels);
+		outputStream << format("  Levels coarsen monotonically: {}", isMonotonic ? "passed" : "FAILED") << endl;
+		isPassed &= isMonotonic;
+	}
+	return isPassed;
+}
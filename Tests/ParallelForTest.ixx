@@ -0,0 +1,61 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+export module ParallelForTest;
+
+import ThreadHelpers;
+
+using namespace std;
+using namespace ThreadHelpers;
+
+/*
+ * Checks that ParallelFor runs every index exactly once, rethrows the exception of the lowest failing index,
+ * and completes when nested in itself with more outer indices than pool threads, which used to deadlock.
+ * Prints each check; returns whether all of them held.
+ */
+export bool TestParallelFor(ostream& outputStream) {
+	constexpr size_t Count = 10000, OuterCount = 256, InnerCount = 64, FirstFailingIndex = 37;
+
+	auto isPassed = true;
+	const auto Check = [&](string_view name, bool value) {
+		outputStream << format("  {}: {}", name, value ? "passed" : "FAILED") << endl;
+		isPassed &= value;
+	};
+
+	{
+		vector<atomic_uint32_t> runCounts(Count);
+		ParallelFor(Count, [&](size_t index) { runCounts[index]++; });
+		Check("Every index once", ranges::all_of(runCounts, [](const auto& runCount) { return runCount == 1; }));
+	}
+
+	{
+		string message;
+		try {
+			ParallelFor(Count, [&](size_t index) {
+				if (index % 100 == FirstFailingIndex) {
+					throw runtime_error(to_string(index));
+				}
+			});
+		}
+		catch (const runtime_error& e) {
+			message = e.what();
+		}
+		Check("First exception in index order", message == to_string(FirstFailingIndex));
+	}
+
+	{
+		atomic_size_t runCount;
+		ParallelFor(OuterCount, [&](size_t) { ParallelFor(InnerCount, [&](size_t) { runCount++; }); });
+		Check("Nested", runCount == OuterCount * InnerCount);
+	}
+
+	return isPassed;
+}
@@ -0,0 +1,108 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+
+#include "JSONHelpers.h"
+
+export module SceneDescBenchmark;
+
+import ErrorHelpers;
+import MemoryMappedFile;
+import MyScene;
+
+using namespace ErrorHelpers;
+using namespace std;
+using namespace std::chrono;
+using namespace std::filesystem;
+
+namespace {
+	constexpr size_t ModelCount = 16;
+
+	void WriteSceneDesc(const path& filePath, size_t renderObjectCount) {
+		ofstream file(filePath, ios::binary | ios::trunc);
+		ThrowIfFailed(static_cast<BOOL>(file.is_open()));
+
+		file << R"({"Camera":{"Position":{"X":0,"Y":1,"Z":-10}},"Models":{)";
+		for (size_t i = 0; i < ModelCount; i++) {
+			file << format(R"({}"Model{}":"Model{}.gltf")", i ? "," : "", i, i);
+		}
+		file << R"(},"RenderObjects":[)";
+		for (size_t i = 0; i < renderObjectCount; i++) {
+			file << format(
+				R"({}{{"Name":"Object{}","Model":"Model{}","Transform":{{"Translation":{{"X":{},"Y":0,"Z":{}}},"Scale":{{"X":1,"Y":1,"Z":1}}}}}})",
+				i ? "," : "", i, i % ModelCount, i % 1000, i / 1000
+			);
+		}
+		file << "]}";
+
+		ThrowIfFailed(static_cast<BOOL>(file.good()));
+	}
+
+	// What MySceneDesc did before SceneDescReader: a DOM of the whole document, converted with from_json, then a check per render object
+	SceneDesc ReadSceneDescDOM(const path& filePath) {
+		const MemoryMappedFile file(filePath);
+		const auto data = file.GetData();
+		const auto json = ordered_json_f::parse(reinterpret_cast<const char*>(::data(data)), reinterpret_cast<const char*>(::data(data) + size(data)));
+
+		SceneDesc sceneDesc;
+		json.get_to(sceneDesc);
+		for (const auto& renderObject : sceneDesc.RenderObjects) {
+			if (!empty(renderObject.Model) && !sceneDesc.Models.contains(renderObject.Model)) {
+				throw runtime_error(format("{}: Models {} not found", filePath.string(), renderObject.Model));
+			}
+		}
+		return sceneDesc;
+	}
+
+	// Compares what WriteSceneDesc sets
+	bool IsEqual(const SceneDesc& a, const SceneDesc& b) {
+		const auto IsRenderObjectEqual = [](const auto& a, const auto& b) {
+			return a.Name == b.Name && a.Model == b.Model && a.Animation == b.Animation && a.IsVisible == b.IsVisible
+				&& a.Transform.Translation == b.Transform.Translation && a.Transform.Rotation == b.Transform.Rotation && a.Transform.Scale == b.Transform.Scale;
+		};
+		return a.Camera.Position == b.Camera.Position && a.Models == b.Models && ranges::equal(a.RenderObjects, b.RenderObjects, IsRenderObjectEqual);
+	}
+}
+
+/*
+ * Generates scene descriptions of 10k, 100k and 1M render objects referencing 16 models, then prints how long
+ * MySceneDesc, which streams RenderObjects through SceneDescReader, and the DOM parser it replaced take to read each of them.
+ * Each file has just been written, so both read it from the file cache.
+ * Returns whether both read every render object the same.
+ */
+export bool BenchmarkSceneDesc(ostream& outputStream) {
+	const auto filePath = temp_directory_path() / "SceneDescBenchmark.json";
+
+	auto isPassed = true;
+
+	for (const auto renderObjectCount : { size_t{ 10'000 }, size_t{ 100'000 }, size_t{ 1'000'000 } }) {
+		WriteSceneDesc(filePath, renderObjectCount);
+
+		const auto Measure = [&](const auto& read) {
+			const auto startTime = steady_clock::now();
+			auto sceneDesc = read();
+			const duration<double, milli> elapsed = steady_clock::now() - startTime;
+			return pair(move(sceneDesc), elapsed.count());
+		};
+		const auto [SAXSceneDesc, SAXTime] = Measure([&] { return MySceneDesc(filePath); });
+		const auto [DOMSceneDesc, DOMTime] = Measure([&] { return ReadSceneDescDOM(filePath); });
+
+		outputStream << format(
+			"{} render objects, {:.1f} MiB: SAX {:.1f} ms, DOM {:.1f} ms ({:.2f}x)",
+			renderObjectCount, static_cast<double>(file_size(filePath)) / (1 << 20), SAXTime, DOMTime, SAXTime > 0 ? DOMTime / SAXTime : 0.0
+		) << endl;
+
+		const auto isEqual = size(SAXSceneDesc.RenderObjects) == renderObjectCount && IsEqual(SAXSceneDesc, DOMSceneDesc);
+		outputStream << format("  SAX matches DOM: {}", isEqual ? "passed" : "FAILED") << endl;
+		isPassed &= isEqual;
+	}
+
+	error_code errorCode;
+	remove(filePath, errorCode);
+
+	return isPassed;
+}
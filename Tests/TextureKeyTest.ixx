@@ -0,0 +1,39 @@
+module;
+
+#include <format>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+export module TextureKeyTest;
+
+import TextureCompression;
+
+using namespace DirectX::TextureHelpers;
+using namespace std;
+
+/*
+ * Checks that texture keys are the SHA-256 they are documented to be, so that they stay the same across runs, builds and machines,
+ * and that they tell apart both data and settings. Prints each check; returns whether all of them held.
+ */
+export bool TestTextureKey(ostream& outputStream) {
+	// SHA-256 of TextureKeyVersion and the settings as little-endian 32-bit and 64-bit integers, then "abc"
+	static_assert(TextureKeyVersion == 1, "Update the expected digest along with TextureKeyVersion");
+	constexpr string_view ExpectedDigest = "613b063e6a7cfac1edf17e4b3bf7ae9a448a23da280bd1474cb0eaf1318b9059";
+
+	const auto data = as_bytes(span("abc", 3)), otherData = as_bytes(span("abd", 3));
+	const auto key = GetTextureKey(data, 0);
+
+	auto isPassed = true;
+	const auto Check = [&](string_view name, bool value) {
+		outputStream << format("  {}: {}", name, value ? "passed" : "FAILED") << endl;
+		isPassed &= value;
+	};
+	Check("Known digest", key.ToString() == ExpectedDigest);
+	Check("Source size", key.SourceSize == size(data));
+	Check("Deterministic", GetTextureKey(data, 0) == key && TextureKey::Hasher()(GetTextureKey(data, 0)) == TextureKey::Hasher()(key));
+	Check("Settings distinguished", GetTextureKey(data, 1) != key);
+	Check("Data distinguished", GetTextureKey(otherData, 0) != key);
+	Check("Empty data keyed", static_cast<bool>(GetTextureKey({}, 0)));
+	return isPassed;
+}
@@ -0,0 +1,188 @@
+module;
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <random>
+#include <span>
+#include <vector>
+
+export module TextureStreamingBenchmark;
+
+import TextureStreaming;
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * Drives TextureResidencyManager with simulated feedback: BC7 textures of 256 to 4096 texels are spread along a line that the camera travels,
+ * textures within view ask for the mip their distance calls for, and loads complete a few frames after they are issued.
+ * Halfway through, a tenth of the textures is replaced, as a streamed scene would.
+ * Every frame checks that the budget holds, that tails stay resident, that evictions spare textures with loads in flight,
+ * and that the usage the manager reports matches the one recomputed from its textures.
+ * Prints the checks, the number of loads and evictions, and how far resident mips lag behind requests; returns whether all checks held.
+ */
+export bool BenchmarkTextureStreaming(ostream& outputStream) {
+	constexpr size_t TextureCount = 512, FrameCount = 2000, MaxLoadCount = 16, TailSize = 64 * 1024;
+	constexpr uint64_t LoadLatency = 3;
+	constexpr float WorldLength = 1000, ViewDistance = 150;
+
+	mt19937 generator(1);
+
+	struct SimulatedTexture {
+		TextureResidencyManager::TextureID ID;
+		vector<size_t> MipSizes;
+		uint32_t TailMip;
+		float Position;
+	};
+	const auto CreateMipSizes = [&] {
+		const auto size = 256u << uniform_int_distribution(0, 4)(generator);
+		vector<size_t> mipSizes;
+		for (auto width = size; ; width /= 2) {
+			// 16 bytes per block of 4x4 texels
+			const auto blockCount = max(width / 4, 1u);
+			mipSizes.emplace_back(static_cast<size_t>(blockCount) * blockCount * 16);
+			if (width == 1) {
+				break;
+			}
+		}
+		return mipSizes;
+	};
+
+	vector<SimulatedTexture> textures(TextureCount);
+	size_t tailTotal = 0, fullTotal = 0;
+	for (auto& texture : textures) {
+		texture.MipSizes = CreateMipSizes();
+		texture.Position = uniform_real_distribution(0.0f, WorldLength)(generator);
+		for (const auto mipSize : texture.MipSizes) {
+			fullTotal += mipSize;
+		}
+	}
+
+	// A quarter of what every texture at full detail would take
+	TextureResidencyManager residencyManager(fullTotal / 4);
+	const auto Register = [&](SimulatedTexture& texture) {
+		const auto tailMipCount = TextureResidencyManager::GetTailMipCount(texture.MipSizes, TailSize);
+		texture.TailMip = static_cast<uint32_t>(size(texture.MipSizes)) - tailMipCount;
+		texture.ID = residencyManager.Register(texture.MipSizes, tailMipCount);
+		for (auto mip = texture.TailMip; mip < size(texture.MipSizes); mip++) {
+			tailTotal += texture.MipSizes[mip];
+		}
+	};
+	for (auto& texture : textures) {
+		Register(texture);
+	}
+
+	struct PendingLoad {
+		TextureResidencyManager::TextureID ID;
+		uint32_t Mip;
+		uint64_t CompletionFrame;
+	};
+	vector<PendingLoad> pendingLoads;
+
+	bool isBudgetKept = true, areTailsKept = true, areEvictionsValid = true, isUsageConsistent = true;
+	size_t loadCount = 0, evictionCount = 0, maxUsage = 0;
+	double lagSum = 0;
+	size_t requestCount = 0, satisfiedRequestCount = 0;
+
+	const auto startTime = steady_clock::now();
+	for (uint64_t frame = 0; frame < FrameCount; frame++) {
+		if (frame == FrameCount / 2) {
+			for (size_t i = 0; i < TextureCount / 10; i++) {
+				auto& texture = textures[uniform_int_distribution<size_t>(0, TextureCount - 1)(generator)];
+				residencyManager.Unregister(texture.ID);
+				for (auto mip = texture.TailMip; mip < size(texture.MipSizes); mip++) {
+					tailTotal -= texture.MipSizes[mip];
+				}
+				erase_if(pendingLoads, [&](const PendingLoad& load) { return load.ID == texture.ID; });
+				texture.MipSizes = CreateMipSizes();
+				Register(texture);
+			}
+		}
+
+		erase_if(pendingLoads, [&](const PendingLoad& load) {
+			if (load.CompletionFrame > frame) {
+				return false;
+			}
+			residencyManager.OnLoaded(load.ID, load.Mip);
+			return true;
+		});
+
+		// Back and forth along the line, over four passes
+		const auto phase = fmod(static_cast<float>(frame) / FrameCount * 4, 2.0f);
+		const auto cameraPosition = (phase < 1 ? phase : 2 - phase) * WorldLength;
+		vector<pair<size_t, uint32_t>> requests;
+		for (size_t i = 0; const auto & texture : textures) {
+			if (const auto distance = abs(texture.Position - cameraPosition); distance < ViewDistance) {
+				// One mip coarser each time the distance doubles past 4
+				const auto mip = static_cast<uint32_t>(max(log2(max(distance, 1.0f) / 4), 0.0f));
+				residencyManager.RequestMip(texture.ID, mip, frame);
+				requests.emplace_back(i, min(mip, texture.TailMip));
+			}
+			i++;
+		}
+
+		for (const auto& [Type, ID, Mip] : residencyManager.Update(frame, MaxLoadCount)) {
+			const auto texture = ranges::find(textures, ID, &SimulatedTexture::ID);
+			if (Type == TextureResidencyManager::CommandType::Load) {
+				pendingLoads.emplace_back(ID, Mip, frame + LoadLatency);
+				loadCount++;
+			}
+			else {
+				areTailsKept &= Mip <= texture->TailMip;
+				areEvictionsValid &= !ranges::contains(pendingLoads, ID, &PendingLoad::ID);
+				evictionCount++;
+			}
+		}
+
+		size_t resident = 0, pending = 0;
+		for (const auto& texture : textures) {
+			const auto residentMip = residencyManager.GetResidentMip(texture.ID);
+			areTailsKept &= residentMip <= texture.TailMip;
+			for (auto mip = residentMip; mip < size(texture.MipSizes); mip++) {
+				resident += texture.MipSizes[mip];
+			}
+		}
+		for (const auto& [ID, Mip, CompletionFrame] : pendingLoads) {
+			pending += ranges::find(textures, ID, &SimulatedTexture::ID)->MipSizes[Mip];
+		}
+		const auto& usage = residencyManager.GetUsage();
+		isUsageConsistent &= usage.Resident == resident && usage.Pending == pending && usage.TextureCount == TextureCount;
+		isBudgetKept &= resident + pending <= max(residencyManager.GetBudget(), tailTotal);
+		maxUsage = max(maxUsage, resident + pending);
+
+		for (const auto& [Index, Mip] : requests) {
+			const auto residentMip = residencyManager.GetResidentMip(textures[Index].ID);
+			lagSum += residentMip - min(residentMip, Mip);
+			satisfiedRequestCount += residentMip <= Mip;
+		}
+		requestCount += size(requests);
+	}
+	const duration<double, milli> elapsed = steady_clock::now() - startTime;
+
+	const auto ToMiB = [](size_t size) { return static_cast<double>(size) / (1 << 20); };
+	outputStream << format(
+		"{} textures, {} frames in {:.1f} ms: budget {:.1f} MiB of {:.1f} MiB at full detail, peak {:.1f} MiB",
+		TextureCount, FrameCount, elapsed.count(), ToMiB(residencyManager.GetBudget()), ToMiB(fullTotal), ToMiB(maxUsage)
+	) << endl;
+	outputStream << format(
+		"{} loads, {} evictions, {:.1f}% of requests satisfied, {:.3f} mips of lag on average",
+		loadCount, evictionCount,
+		requestCount ? 100.0 * satisfiedRequestCount / requestCount : 100.0, requestCount ? lagSum / requestCount : 0.0
+	) << endl;
+
+	const pair<const char*, bool> checks[]{
+		{ "Budget kept", isBudgetKept },
+		{ "Tails kept", areTailsKept },
+		{ "Evictions spare loads in flight", areEvictionsValid },
+		{ "Usage consistent", isUsageConsistent }
+	};
+	auto isPassed = true;
+	for (const auto& [Name, IsPassed] : checks) {
+		outputStream << format("  {}: {}", Name, IsPassed ? "passed" : "FAILED") << endl;
+		isPassed &= IsPassed;
+	}
+	return isPassed;
+}
@@ -0,0 +1,201 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <ostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "directx/d3d12.h"
+
+export module VertexFetchBenchmark;
+
+import GLTFHelpers;
+import MeshOptimization;
+
+using namespace DirectX;
+using namespace std;
+using namespace std::filesystem;
+
+namespace {
+	// Set-associative LRU cache of the size of a GPU L1
+	class CacheSimulator {
+	public:
+		static constexpr size_t LineSize = 64, Size = 32 << 10, Associativity = 8, SetCount = Size / LineSize / Associativity;
+
+		uint64_t AccessCount{}, MissCount{};
+
+		void Access(uint64_t address, size_t byteCount) {
+			for (auto line = address / LineSize; line <= (address + byteCount - 1) / LineSize; line++) {
+				AccessCount++;
+				const auto ways = span(m_ways).subspan(line % SetCount * Associativity, Associativity);
+				m_time++;
+				if (const auto way = ranges::find(ways, line, &Way::Line); way != cend(ways)) {
+					way->Time = m_time;
+				}
+				else {
+					MissCount++;
+					*ranges::min_element(ways, {}, &Way::Time) = { line, m_time };
+				}
+			}
+		}
+
+	private:
+		struct Way {
+			uint64_t Line = ~0ull, Time{};
+		};
+		vector<Way> m_ways = vector<Way>(SetCount * Associativity);
+		uint64_t m_time{};
+	};
+
+	constexpr uint64_t VertexBufferAddress = 1ull << 40;
+	constexpr size_t HitsPerWave = 32, TrianglesPerCell = 32;
+
+	size_t GetIndexStride(const MeshData& meshData) {
+		return meshData.IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	uint32_t GetIndex(const MeshData& meshData, size_t i) {
+		return GetIndexStride(meshData) == sizeof(uint16_t) ?
+			reinterpret_cast<const uint16_t*>(data(meshData.Indices))[i] :
+			reinterpret_cast<const uint32_t*>(data(meshData.Indices))[i];
+	}
+
+	/*
+	 * Returns the triangles of the mesh by the positions of their vertices, sorted, each rotated to start at its smallest vertex
+	 * so that it compares equal regardless of which vertex its indices start at, as long as its winding is kept.
+	 */
+	vector<array<float, 9>> GetSortedTriangles(const MeshData& meshData) {
+		vector<array<float, 9>> triangles(meshData.GetIndexCount() / 3);
+		for (size_t i = 0; auto & triangle : triangles) {
+			for (size_t j = 0; j < 3; j++) {
+				const auto& position = meshData.Vertices[GetIndex(meshData, i * 3 + j)].Position;
+				ranges::copy(initializer_list{ position.x, position.y, position.z }, begin(triangle) + j * 3);
+			}
+			const auto GetVertex = [&](size_t j) { return span(triangle).subspan(j * 3, 3); };
+			size_t first = 0;
+			for (size_t j = 1; j < 3; j++) {
+				if (ranges::lexicographical_compare(GetVertex(j), GetVertex(first))) {
+					first = j;
+				}
+			}
+			ranges::rotate(triangle, begin(triangle) + first * 3);
+			i++;
+		}
+		ranges::sort(triangles);
+		return triangles;
+	}
+
+	/*
+	 * Replays the fetches of CastRay for waves of rays that hit random triangles within a small region each:
+	 * triangles are bucketed in a grid of about TrianglesPerCell triangles per cell, and each wave picks a cell.
+	 * The seed is fixed, so that meshes with the same triangles in another order are hit at the same places.
+	 */
+	size_t SimulateHits(const MeshData& meshData, CacheSimulator& cache) {
+		const auto indexStride = GetIndexStride(meshData);
+
+		const auto triangleCount = meshData.GetIndexCount() / 3;
+		if (!triangleCount) {
+			return 0;
+		}
+
+		vector<XMFLOAT3> centroids(triangleCount);
+		auto minCentroid = XMVectorReplicate(FLT_MAX), maxCentroid = XMVectorReplicate(-FLT_MAX);
+		for (size_t i = 0; i < triangleCount; i++) {
+			auto centroid = XMVectorZero();
+			for (size_t j = 0; j < 3; j++) {
+				centroid += XMLoadFloat3(&meshData.Vertices[GetIndex(meshData, i * 3 + j)].Position);
+			}
+			centroid /= 3;
+			XMStoreFloat3(&centroids[i], centroid);
+			minCentroid = XMVectorMin(minCentroid, centroid);
+			maxCentroid = XMVectorMax(maxCentroid, centroid);
+		}
+
+		const auto gridSize = max<size_t>(static_cast<size_t>(round(cbrt(static_cast<double>(triangleCount) / TrianglesPerCell))), 1);
+		const auto scale = XMVectorReplicate(static_cast<float>(gridSize)) / XMVectorMax(maxCentroid - minCentroid, XMVectorReplicate(FLT_MIN));
+		vector<vector<uint32_t>> cells(gridSize * gridSize * gridSize);
+		for (uint32_t i = 0; const auto & centroid : centroids) {
+			XMFLOAT3 cell;
+			XMStoreFloat3(&cell, XMVectorMin((XMLoadFloat3(&centroid) - minCentroid) * scale, XMVectorReplicate(static_cast<float>(gridSize - 1))));
+			cells[(static_cast<size_t>(cell.z) * gridSize + static_cast<size_t>(cell.y)) * gridSize + static_cast<size_t>(cell.x)].emplace_back(i++);
+		}
+		erase_if(cells, [](const auto& cell) { return empty(cell); });
+
+		mt19937 generator;
+		const auto waveCount = triangleCount / HitsPerWave + 1;
+		for (size_t wave = 0; wave < waveCount; wave++) {
+			const auto& cell = cells[uniform_int_distribution<size_t>(0, size(cells) - 1)(generator)];
+			for (size_t hit = 0; hit < HitsPerWave; hit++) {
+				const auto triangle = cell[uniform_int_distribution<size_t>(0, size(cell) - 1)(generator)];
+				cache.Access(triangle * 3 * indexStride, 3 * indexStride);
+				for (size_t j = 0; j < 3; j++) {
+					cache.Access(VertexBufferAddress + GetIndex(meshData, triangle * 3 + j) * sizeof(Mesh::VertexType), sizeof(Mesh::VertexType));
+				}
+			}
+		}
+		return waveCount * HitsPerWave;
+	}
+}
+
+/*
+ * Prints, for each model, how well a simulated L1 cache serves the index and vertex fetches of ray hits
+ * with triangles in the order they are imported without reordering, then with the spatial reordering of OptimizeMesh.
+ * Returns whether reordering kept every triangle of every mesh with its winding.
+ */
+export bool BenchmarkVertexFetch(span<const path> filePaths, ostream& outputStream) {
+	auto isPassed = true;
+	for (const auto& filePath : filePaths) {
+		ModelData modelData;
+		GLTFHelpers::DecodeModel(modelData, filePath, false, { .IsReorderingEnabled = false });
+
+		struct Statistics {
+			uint64_t HitCount, AccessCount, MissCount;
+		} statistics[2]{};
+		const auto Simulate = [&](const MeshData& meshData, Statistics& _statistics) {
+			// Caches start cold for every mesh
+			CacheSimulator cache;
+			_statistics.HitCount += SimulateHits(meshData, cache);
+			_statistics.AccessCount += cache.AccessCount;
+			_statistics.MissCount += cache.MissCount;
+		};
+
+		size_t meshCount = 0, triangleCount = 0, vertexCount = 0;
+		auto isPreserved = true;
+		for (const auto& meshNode : modelData.MeshNodes) {
+			for (const auto& meshData : meshNode.Meshes) {
+				meshCount++;
+				triangleCount += meshData.GetIndexCount() / 3;
+				vertexCount += size(meshData.Vertices);
+
+				Simulate(meshData, statistics[0]);
+
+				auto reorderedMeshData = meshData;
+				ReorderMesh(reorderedMeshData);
+				Simulate(reorderedMeshData, statistics[1]);
+
+				isPreserved &= GetSortedTriangles(reorderedMeshData) == GetSortedTriangles(meshData);
+			}
+		}
+
+		outputStream << format("{}: {} meshes, {} triangles, {} vertices", filePath.string(), meshCount, triangleCount, vertexCount) << endl;
+		for (size_t i = 0; const auto name : { "Imported order", "Reordered" }) {
+			const auto& [HitCount, AccessCount, MissCount] = statistics[i++];
+			outputStream << format(
+				"  {}: {:.2f} bytes fetched per hit, {:.1f}% line miss rate",
+				name,
+				HitCount ? static_cast<double>(MissCount * CacheSimulator::LineSize) / HitCount : 0.0,
+				AccessCount ? 100.0 * MissCount / AccessCount : 0.0
+			) << endl;
+		}
+		outputStream << format("  Triangles preserved: {}", isPreserved ? "passed" : "FAILED") << endl;
+		isPassed &= isPreserved;
+	}
+	return isPassed;
+}